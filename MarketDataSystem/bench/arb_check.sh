@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+# A/B arbitration check
+#
+# Starts two publishers on the same seeded schedule, line A over TCP and
+# line B over shared memory with injected delay and loss, runs arb_consumer
+# against both and checks the released stream: nothing released twice or
+# out of order, every hole one the arbiter counted as lost, and, when at
+# least one line is lossless, every update released with none lost.
+#
+#   bench/arb_check.sh [build-dir]
+#
+# Environment: COUNT (20000), RATE (10000), A_DROP (0), B_DELAY_US (30),
+# B_DROP (0.01), GAP_TIMEOUT_US (1000), PORT (18180). Exits non-zero on
+# failure; logs are left in the printed work directory.
+
+set -u
+
+BIN=${1:-build}
+COUNT=${COUNT:-20000}
+RATE=${RATE:-10000}
+A_DROP=${A_DROP:-0}
+B_DELAY_US=${B_DELAY_US:-30}
+B_DROP=${B_DROP:-0.01}
+GAP_TIMEOUT_US=${GAP_TIMEOUT_US:-1000}
+PORT=${PORT:-18180}
+SHM_A=/arb_check_a
+SHM_B=/arb_check_b
+
+for program in publisher arb_consumer; do
+    if [ ! -x "$BIN/$program" ]; then
+        echo "Error: $BIN/$program not found (pass the build directory)"
+        exit 1
+    fi
+done
+
+WORK=$(mktemp -d /tmp/arb_check.XXXXXX)
+echo "Logs in $WORK"
+PIDS=()
+cleanup() {
+    for pid in "${PIDS[@]}"; do
+        kill -INT "$pid" 2>/dev/null
+    done
+    wait 2>/dev/null
+}
+trap cleanup EXIT
+
+rm -f "/dev/shm$SHM_A" "/dev/shm$SHM_B"
+
+# The consumer must be attached before the first update: start in 4 s,
+# which leaves room for both publishers to calibrate their clocks
+T=$(( $(date +%s) + 4 ))
+"$BIN/publisher" --seed 7 --start-at "$T" --rate "$RATE" --count "$COUNT" -q \
+    --port "$PORT" --shm-name "$SHM_A" --drop-rate "$A_DROP" > "$WORK/publisher_a.log" 2>&1 &
+PIDS+=($!)
+"$BIN/publisher" --seed 7 --start-at "$T" --rate "$RATE" --count "$COUNT" -q \
+    --port $(( PORT + 1 )) --shm-name "$SHM_B" --delay-us "$B_DELAY_US" --drop-rate "$B_DROP" \
+    > "$WORK/publisher_b.log" 2>&1 &
+PIDS+=($!)
+
+# Logs are block-buffered, so wait on what the publishers create instead
+for _ in $(seq 150); do
+    [ -e "/dev/shm$SHM_B" ] && (exec 3<> "/dev/tcp/127.0.0.1/$PORT") 2>/dev/null && break
+    sleep 0.02
+done
+if [ "$(date +%s)" -ge "$T" ]; then
+    echo "Error: publishers were not ready before the start time (see $WORK)"
+    exit 1
+fi
+
+# Stopped with SIGTERM if it never reaches --count (updates lost on both lines)
+LIMIT=$(( T - $(date +%s) + COUNT / RATE + 10 ))
+timeout "$LIMIT" "$BIN/arb_consumer" -q --count "$COUNT" --gap-timeout-us "$GAP_TIMEOUT_US" \
+    --a "tcp:127.0.0.1:$PORT" --b "shm:$SHM_B" > "$WORK/arb_consumer.log" 2>&1
+
+summary=$(grep -E "^Shutting down" "$WORK/arb_consumer.log")
+check=$(grep -E "^Sequence check" "$WORK/arb_consumer.log")
+if [ -z "$summary" ] || [ -z "$check" ]; then
+    echo "FAIL: arb_consumer did not report (see $WORK/arb_consumer.log)"
+    exit 1
+fi
+emitted=$(sed -E 's/.*Emitted ([0-9]+) updates.*/\1/' <<< "$summary")
+lost=$(sed -E 's/.*, ([0-9]+) lost.*/\1/' <<< "$summary")
+missing=$(sed -E 's/.*: ([0-9]+) missing.*/\1/' <<< "$check")
+duplicates=$(sed -E 's/.*, ([0-9]+) duplicate.*/\1/' <<< "$check")
+
+echo "A: drop $A_DROP; B: delay ${B_DELAY_US} us, drop $B_DROP"
+echo "Emitted $emitted of $COUNT, lost $lost, missing $missing, duplicate or out of order $duplicates"
+grep -E "^Line [AB]:" "$WORK/arb_consumer.log"
+
+status=0
+if [ "$duplicates" -ne 0 ]; then
+    echo "FAIL: updates released twice or out of order"
+    status=2
+fi
+if [ "$missing" -ne "$lost" ]; then
+    echo "FAIL: $missing updates missing from the released stream, $lost counted lost"
+    status=2
+fi
+if [ "$A_DROP" = "0" ] || [ "$B_DROP" = "0" ]; then
+    if [ "$emitted" -ne "$COUNT" ] || [ "$lost" -ne 0 ]; then
+        echo "FAIL: a lossless line should leave no gaps"
+        status=2
+    fi
+fi
+[ "$status" -eq 0 ] && echo "PASS"
+exit "$status"
@@ -0,0 +1,357 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include "../include/latency_histogram.h"
+
+// End-to-end transport latency harness
+//
+// Launches a publisher and the chosen consumers from the build directory
+// with the same rate, message count, pinning and wait mode, lets the
+// publisher start them all at one instant (--start-at), waits until each
+// consumer has received --count updates and collects the histogram
+// (--hist-out) and receive throughput from every one. Results go to stdout
+// and optionally to CSV (appended, so runs of different builds line up in
+// one file) and JSON. The feed is seeded, so every run sends the same data.
+
+namespace {
+
+struct Options {
+    std::vector<std::string> consumers{"shm", "tcp"};
+    uint64_t rate = 10'000;
+    uint64_t count = 100'000;
+    bool busy_wait = false;
+    bool compact = false;
+    int publisher_cpu = 0;
+    int io_cpu = 1;
+    int shm_cpu = 2;
+    int tcp_cpu = 3;
+    int arb_cpu = 4;
+    int port = 18080;
+    std::string shm_name = "/market_data_e2e";
+    std::string label = "run";
+    std::string bin_dir;
+    const char* csv = nullptr;
+    const char* json = nullptr;
+};
+
+struct Process {
+    std::string name;
+    std::string log;
+    std::string hist;
+    pid_t pid = -1;
+    int status = 0;
+};
+
+struct Result {
+    std::string consumer;
+    uint64_t received;
+    double throughput;
+    uint64_t mean;
+    LatencyHistogram::Percentiles latency;
+    bool exited_cleanly;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Directory holding this executable; the other binaries are built next to it
+std::string own_dir() {
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0) {
+        return ".";
+    }
+    path[n] = '\0';
+    char* slash = std::strrchr(path, '/');
+    return slash != nullptr ? std::string(path, slash) : ".";
+}
+
+// Start program with stdout and stderr redirected to log
+pid_t spawn(const std::string& program, const std::vector<std::string>& args, const std::string& log) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+    }
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(program.c_str()));
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execv(program.c_str(), argv.data());
+    std::perror("execv");
+    _exit(127);
+}
+
+bool wait_until(pid_t pid, int& status, std::chrono::steady_clock::time_point deadline) {
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// Interrupt and reap; returns true if the process had already exited
+bool stop(Process& process, std::chrono::steady_clock::time_point deadline) {
+    if (wait_until(process.pid, process.status, deadline)) {
+        return true;
+    }
+    kill(process.pid, SIGINT);
+    if (!wait_until(process.pid, process.status, std::chrono::steady_clock::now() + std::chrono::seconds(5))) {
+        kill(process.pid, SIGKILL);
+        waitpid(process.pid, &process.status, 0);
+    }
+    return false;
+}
+
+bool wait_for_shm(const std::string& name, std::chrono::steady_clock::time_point deadline) {
+    while (std::chrono::steady_clock::now() < deadline) {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd != -1) {
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// "Throughput: N msg/s" from a consumer's exit summary
+double read_throughput(const std::string& log) {
+    std::ifstream file(log);
+    std::string line;
+    double throughput = 0.0;
+    while (std::getline(file, line)) {
+        if (line.rfind("Throughput: ", 0) == 0) {
+            throughput = std::atof(line.c_str() + 12);
+        }
+    }
+    return throughput;
+}
+
+std::vector<std::string> consumer_args(const Options& options, const std::string& name, const std::string& hist) {
+    std::vector<std::string> args{
+        "-q", "--report-interval", "0", "--hist-out", hist, "--count", std::to_string(options.count)};
+    if (options.busy_wait) {
+        args.push_back("--busy-wait");
+    }
+    std::string port = std::to_string(options.port);
+    if (name == "shm") {
+        args.insert(args.end(), {"--cpu", std::to_string(options.shm_cpu), "--shm-name", options.shm_name});
+    } else if (name == "tcp") {
+        args.insert(args.end(), {"--cpu", std::to_string(options.tcp_cpu), "--port", port,
+            "--shm-name", options.shm_name});
+        if (options.compact) {
+            args.push_back("--compact");
+        }
+    } else {
+        // Two TCP sessions: the shm ring has a single consumer
+        args.insert(args.end(), {"--cpu", std::to_string(options.arb_cpu),
+            "--a", "tcp:127.0.0.1:" + port, "--b", "tcp:127.0.0.1:" + port, "--shm-name", options.shm_name});
+    }
+    return args;
+}
+
+void write_csv(const char* path, const Options& options, const std::vector<Result>& results) {
+    struct stat st;
+    bool fresh = stat(path, &st) != 0 || st.st_size == 0;
+    FILE* file = std::fopen(path, "a");
+    if (file == nullptr) {
+        fmt::print("Warning: Could not write {}\n", path);
+        return;
+    }
+    if (fresh) {
+        fmt::print(file, "label,consumer,rate,count,wait,received,throughput,mean_ns,"
+                         "p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns\n");
+    }
+    for (const Result& r : results) {
+        fmt::print(file, "{},{},{},{},{},{},{:.0f},{},{},{},{},{},{},{}\n",
+            options.label, r.consumer, options.rate, options.count, options.busy_wait ? "busy" : "sleep",
+            r.received, r.throughput, r.mean, r.latency.p50, r.latency.p90, r.latency.p99,
+            r.latency.p999, r.latency.p9999, r.latency.max);
+    }
+    std::fclose(file);
+}
+
+void write_json(const char* path, const Options& options, const std::vector<Result>& results) {
+    FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        fmt::print("Warning: Could not write {}\n", path);
+        return;
+    }
+    fmt::print(file, "{{\"label\":\"{}\",\"rate\":{},\"count\":{},\"wait\":\"{}\",\"results\":[",
+        options.label, options.rate, options.count, options.busy_wait ? "busy" : "sleep");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        fmt::print(file, "{}\n  {{\"consumer\":\"{}\",\"received\":{},\"throughput\":{:.0f},\"mean_ns\":{},"
+                         "\"p50_ns\":{},\"p90_ns\":{},\"p99_ns\":{},\"p999_ns\":{},\"p9999_ns\":{},\"max_ns\":{}}}",
+            i == 0 ? "" : ",", r.consumer, r.received, r.throughput, r.mean, r.latency.p50, r.latency.p90,
+            r.latency.p99, r.latency.p999, r.latency.p9999, r.latency.max);
+    }
+    fmt::print(file, "\n]}}\n");
+    std::fclose(file);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--consumers") == 0 && i + 1 < argc) {
+            options.consumers = split(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            options.rate = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            options.count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--busy-wait") == 0 || strcmp(argv[i], "-b") == 0) {
+            options.busy_wait = true;
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            options.compact = true;
+        } else if (strcmp(argv[i], "--publisher-cpu") == 0 && i + 1 < argc) {
+            options.publisher_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--io-cpu") == 0 && i + 1 < argc) {
+            options.io_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shm-cpu") == 0 && i + 1 < argc) {
+            options.shm_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tcp-cpu") == 0 && i + 1 < argc) {
+            options.tcp_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--arb-cpu") == 0 && i + 1 < argc) {
+            options.arb_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            options.port = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            options.shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            options.label = argv[++i];
+        } else if (strcmp(argv[i], "--bin-dir") == 0 && i + 1 < argc) {
+            options.bin_dir = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            options.csv = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            options.json = argv[++i];
+        } else {
+            fmt::print("Usage: {} [--consumers shm,tcp,arb] [--rate N] [--count N] [--busy-wait] [--compact]\n"
+                       "  [--publisher-cpu N] [--io-cpu N] [--shm-cpu N] [--tcp-cpu N] [--arb-cpu N]\n"
+                       "  [--port N] [--shm-name NAME] [--label NAME] [--bin-dir DIR] [--csv FILE] [--json FILE]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+    for (const std::string& name : options.consumers) {
+        if (name != "shm" && name != "tcp" && name != "arb") {
+            fmt::print("Error: Unknown consumer '{}' (expected shm, tcp or arb)\n", name);
+            return 1;
+        }
+    }
+    if (options.rate == 0 || options.count == 0) {
+        fmt::print("Error: --rate and --count must be positive\n");
+        return 1;
+    }
+    if (options.bin_dir.empty()) {
+        options.bin_dir = own_dir();
+    }
+
+    char work_dir[] = "/tmp/e2e_bench.XXXXXX";
+    if (mkdtemp(work_dir) == nullptr) {
+        fmt::print("Error: Could not create a work directory\n");
+        return 1;
+    }
+    fmt::print("Logs and histograms in {}\n", work_dir);
+
+    // Consumers must be attached before the first update: start in 2 s
+    uint64_t start_at = static_cast<uint64_t>(std::time(nullptr)) + 2;
+    double run_seconds = static_cast<double>(options.count) / static_cast<double>(options.rate);
+    fmt::print("Publishing {} updates at {}/s ({:.1f} s) to {} ({} wait, {} over TCP)\n",
+        options.count, options.rate, run_seconds, fmt::join(options.consumers, ","),
+        options.busy_wait ? "busy" : "sleep", options.compact ? "compact" : "JSON");
+
+    Process publisher{"publisher", std::string(work_dir) + "/publisher.log", "", -1, 0};
+    publisher.pid = spawn(options.bin_dir + "/publisher", {
+        "--rate", std::to_string(options.rate), "--count", std::to_string(options.count),
+        "--port", std::to_string(options.port), "--shm-name", options.shm_name,
+        "--seed", "1", "--start-at", std::to_string(start_at),
+        "--cpu", std::to_string(options.publisher_cpu), "--io-cpu", std::to_string(options.io_cpu), "-q"},
+        publisher.log);
+    if (!wait_for_shm(options.shm_name, std::chrono::steady_clock::now() + std::chrono::seconds(2))) {
+        fmt::print("Error: Publisher did not create {} (see {})\n", options.shm_name, publisher.log);
+        stop(publisher, std::chrono::steady_clock::now());
+        return 1;
+    }
+
+    std::vector<Process> consumers;
+    for (const std::string& name : options.consumers) {
+        Process process{name, std::string(work_dir) + "/" + name + ".log",
+            std::string(work_dir) + "/" + name + ".hist", -1, 0};
+        std::string program = options.bin_dir + "/" + (name == "arb" ? "arb_consumer" : name + "_consumer");
+        process.pid = spawn(program, consumer_args(options, name, process.hist), process.log);
+        consumers.push_back(process);
+    }
+
+    // Generous slack: a consumer that misses updates never reaches --count
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(12)
+        + std::chrono::milliseconds(static_cast<int64_t>(run_seconds * 1500.0));
+    std::vector<Result> results;
+    for (Process& process : consumers) {
+        bool finished = stop(process, deadline);
+        LatencyHistogram histogram;
+        if (!histogram.load(process.hist.c_str())) {
+            fmt::print("Warning: {} wrote no histogram (see {})\n", process.name, process.log);
+        }
+        results.push_back(Result{process.name, histogram.count(), read_throughput(process.log),
+            histogram.mean(), histogram.percentiles(),
+            finished && WIFEXITED(process.status) && WEXITSTATUS(process.status) == 0});
+    }
+    stop(publisher, std::chrono::steady_clock::now());
+
+    for (const Result& r : results) {
+        fmt::print("{:>4}: {} (avg {} ns), {:.0f} msg/s{}\n", r.consumer, r.latency, r.mean, r.throughput,
+            r.exited_cleanly ? "" : " [timed out or failed]");
+    }
+    if (options.csv != nullptr) {
+        write_csv(options.csv, options, results);
+        fmt::print("Appended to {}\n", options.csv);
+    }
+    if (options.json != nullptr) {
+        write_json(options.json, options, results);
+        fmt::print("Wrote {}\n", options.json);
+    }
+
+    for (const Result& r : results) {
+        if (!r.exited_cleanly || r.received < options.count) {
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "../include/market_data.h"
+#include "../include/instruments.h"
+#include "../include/json_scan.h"
+#include "../include/utils.h"
+
+// JSON encode/decode: the vectorized parser and pair-table formatter in
+// utils.h against the sscanf/snprintf versions they replaced
+
+namespace {
+
+// The previous implementations, kept here as the baseline
+bool sscanf_from_json(const char* json, MarketData& data) {
+    char instrument[16];
+    double bid, ask;
+    unsigned long long timestamp_ns;
+    unsigned long long seq;
+
+    int parsed = std::sscanf(json,
+        "{\"instrument\":\"%15[^\"]\",\"bid\":%lf,\"ask\":%lf,\"timestamp_ns\":%llu,\"seq\":%llu}",
+        instrument, &bid, &ask, &timestamp_ns, &seq);
+    if (parsed != 5) {
+        return false;
+    }
+    std::memset(data.instrument, 0, sizeof(data.instrument));
+    std::memcpy(data.instrument, instrument, strnlen(instrument, sizeof(data.instrument) - 1));
+    data.instrument_id = instruments::find(data.instrument);
+    if (data.instrument_id == instruments::INVALID_ID) {
+        return false;
+    }
+    data.bid = bid;
+    data.ask = ask;
+    data.timestamp_ns = timestamp_ns;
+    data.seq_num = seq;
+    return true;
+}
+
+size_t snprintf_to_json(const MarketData& data, char* buffer, size_t size) {
+    int len = std::snprintf(buffer, size,
+        "{\"instrument\":\"%s\",\"bid\":%.2f,\"ask\":%.2f,\"timestamp_ns\":%lu,\"seq\":%lu}",
+        data.instrument, data.bid, data.ask, data.timestamp_ns, data.seq_num);
+    return len < 0 ? 0 : std::min(static_cast<size_t>(len), size - 1);
+}
+
+// Random-walk quotes on the tick grid, like the publisher's generator
+std::vector<MarketData> make_updates(size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> step(-3, 3);
+    std::uniform_int_distribution<int> spread(1, 10);
+    std::vector<int64_t> mid(instruments::COUNT);
+    for (uint32_t i = 0; i < instruments::COUNT; i++) {
+        mid[i] = static_cast<int64_t>(instruments::UNIVERSE[i].base_price / instruments::TICK_SIZE);
+    }
+
+    std::vector<MarketData> updates;
+    uint64_t ts = 1'700'000'000'000'000'000ULL;
+    for (size_t n = 0; n < count; n++) {
+        uint32_t id = n % instruments::COUNT;
+        mid[id] += step(rng);
+        int64_t bid = mid[id];
+        int64_t ask = bid + spread(rng);
+        updates.emplace_back(instruments::UNIVERSE[id].symbol,
+            bid * instruments::TICK_SIZE, ask * instruments::TICK_SIZE, ts += 997);
+        updates.back().seq_num = n;
+    }
+    return updates;
+}
+
+std::vector<std::string> make_lines(size_t count) {
+    std::vector<std::string> lines;
+    for (const MarketData& data : make_updates(count)) {
+        char buffer[utils::MAX_JSON_SIZE];
+        lines.emplace_back(buffer, snprintf_to_json(data, buffer, sizeof(buffer)));
+    }
+    return lines;
+}
+
+const std::vector<std::string>& lines() {
+    static const std::vector<std::string> cache = make_lines(1024);
+    return cache;
+}
+
+const std::vector<MarketData>& updates() {
+    static const std::vector<MarketData> cache = make_updates(1024);
+    return cache;
+}
+
+// Fail the run if the fast paths disagree with the baseline
+bool outputs_match() {
+    for (size_t i = 0; i < lines().size(); i++) {
+        MarketData fast, slow;
+        if (!utils::from_json(lines()[i].data(), lines()[i].size(), fast) ||
+            !sscanf_from_json(lines()[i].c_str(), slow) ||
+            fast.bid != slow.bid || fast.ask != slow.ask ||
+            fast.timestamp_ns != slow.timestamp_ns || fast.seq_num != slow.seq_num ||
+            std::strcmp(fast.instrument, slow.instrument) != 0) {
+            return false;
+        }
+        char a[utils::MAX_JSON_SIZE], b[utils::MAX_JSON_SIZE];
+        size_t la = utils::to_json(updates()[i], a, sizeof(a));
+        size_t lb = snprintf_to_json(updates()[i], b, sizeof(b));
+        if (la != lb || std::memcmp(a, b, la) != 0) {
+            return false;
+        }
+    }
+    // Symbols outside the universe are a parse error, not an INVALID_ID
+    MarketData data;
+    const std::string unknown = "{\"instrument\":\"NOSUCH\",\"bid\":1.00,\"ask\":1.01,\"timestamp_ns\":1,\"seq\":1}";
+    return !utils::from_json(unknown.data(), unknown.size(), data) && !sscanf_from_json(unknown.c_str(), data);
+}
+
+void BM_FromJson_Sscanf(benchmark::State& state) {
+    MarketData data;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sscanf_from_json(lines()[i++ & 1023].c_str(), data));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FromJson_Sscanf);
+
+void BM_FromJson(benchmark::State& state) {
+    state.SetLabel(json_scan::scan_name());
+    MarketData data;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& line = lines()[i++ & 1023];
+        benchmark::DoNotOptimize(utils::from_json(line.data(), line.size(), data));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FromJson);
+
+template<json_scan::ScanFn Scan>
+void BM_Scan(benchmark::State& state) {
+    json_scan::Structurals marks;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& line = lines()[i++ & 1023];
+        Scan(line.data(), line.size(), marks);
+        benchmark::DoNotOptimize(marks);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Scan, json_scan::scan_scalar);
+#ifdef JSON_SCAN_X86
+BENCHMARK_TEMPLATE(BM_Scan, json_scan::scan_sse2);
+BENCHMARK_TEMPLATE(BM_Scan, json_scan::scan_avx2);
+#endif
+
+void BM_ToJson_Snprintf(benchmark::State& state) {
+    char buffer[utils::MAX_JSON_SIZE];
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(snprintf_to_json(updates()[i++ & 1023], buffer, sizeof(buffer)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ToJson_Snprintf);
+
+void BM_ToJson(benchmark::State& state) {
+    char buffer[utils::MAX_JSON_SIZE];
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(utils::to_json(updates()[i++ & 1023], buffer, sizeof(buffer)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ToJson);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!outputs_match()) {
+        std::fprintf(stderr, "Fast JSON paths disagree with sscanf/snprintf\n");
+        return 1;
+    }
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+#include "../include/async_log.h"
+#include "../include/market_data.h"
+#include "../include/utils.h"
+
+// Caller-side cost of one consumer log line: alog::log against the
+// fmt::print + format_timestamp it replaced. Output goes to /dev/null so
+// the terminal does not dominate.
+
+namespace {
+
+const MarketData& sample() {
+    static const MarketData data("RELIANCE", 2850.25, 2850.30, utils::get_timestamp_ns());
+    return data;
+}
+
+void BM_FmtPrint(benchmark::State& state) {
+    const MarketData& data = sample();
+    for (auto _ : state) {
+        uint64_t receive_ts = utils::get_timestamp_ns();
+        fmt::print("[{}] {} BID={:.2f} ASK={:.2f} (latency: {} ns)\n",
+            utils::format_timestamp(receive_ts), data.instrument, data.bid, data.ask,
+            receive_ts - data.timestamp_ns);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FmtPrint);
+
+void BM_AsyncLog(benchmark::State& state) {
+    const MarketData& data = sample();
+    for (auto _ : state) {
+        uint64_t receive_ts = utils::get_timestamp_ns();
+        alog::log(FMT_STRING("[{}] {} BID={:.2f} ASK={:.2f} (latency: {} ns)\n"),
+            alog::Timestamp{receive_ts}, data.instrument, data.bid, data.ask,
+            receive_ts - data.timestamp_ns);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["dropped"] = static_cast<double>(alog::AsyncLogger::instance().dropped());
+}
+BENCHMARK(BM_AsyncLog);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    // Benchmark results go to stderr; log output is discarded
+    if (std::freopen("/dev/null", "w", stdout) == nullptr) {
+        return 1;
+    }
+    alog::AsyncLogger::instance().start(0);
+    benchmark::RunSpecifiedBenchmarks();
+    alog::AsyncLogger::instance().stop();
+    benchmark::Shutdown();
+    return 0;
+}
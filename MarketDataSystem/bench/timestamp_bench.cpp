@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "../include/tsc_clock.h"
+#include "../include/utils.h"
+
+// utils::format_timestamp (cached prefix, caller buffer) against the
+// stringstream/localtime/put_time version it replaced, and the cost of
+// reading the clock itself (system clock vs calibrated TSC)
+
+namespace {
+
+std::string stream_format_timestamp(uint64_t timestamp_ns) {
+    auto seconds = timestamp_ns / 1'000'000'000;
+    auto nanos = timestamp_ns % 1'000'000'000;
+    time_t time_t_val = static_cast<time_t>(seconds);
+
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&time_t_val), "%H:%M:%S");
+    ss << "." << std::setfill('0') << std::setw(9) << nanos;
+    return ss.str();
+}
+
+// Stamps ~1 us apart, crossing a second boundary every million calls
+uint64_t next_stamp(uint64_t& ts) {
+    return ts += 997;
+}
+
+bool outputs_match() {
+    uint64_t ts = utils::get_timestamp_ns();
+    for (int i = 0; i < 100'000; i++) {
+        uint64_t stamp = next_stamp(ts) + static_cast<uint64_t>(i) * 9'999'991;
+        if (utils::format_timestamp(stamp) != stream_format_timestamp(stamp)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BM_FormatTimestamp_Stream(benchmark::State& state) {
+    uint64_t ts = utils::get_timestamp_ns();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(stream_format_timestamp(next_stamp(ts)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FormatTimestamp_Stream);
+
+void BM_FormatTimestamp(benchmark::State& state) {
+    uint64_t ts = utils::get_timestamp_ns();
+    char buffer[utils::TIMESTAMP_SIZE];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(utils::format_timestamp(next_stamp(ts), buffer));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FormatTimestamp);
+
+void BM_Now_SystemClock(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tsc::clock_ns(CLOCK_REALTIME));
+    }
+}
+BENCHMARK(BM_Now_SystemClock);
+
+void BM_Now_Tsc(benchmark::State& state) {
+    tsc::use(tsc::calibrate());
+    if (!tsc::active.valid) {
+        state.SkipWithError("no invariant TSC");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tsc::now_ns());
+    }
+    tsc::use(tsc::Calibration{});
+}
+BENCHMARK(BM_Now_Tsc);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!outputs_match()) {
+        std::fprintf(stderr, "Cached timestamp formatter disagrees with put_time\n");
+        return 1;
+    }
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
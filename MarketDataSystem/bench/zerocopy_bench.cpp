@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../include/zerocopy.h"
+
+// Loopback throughput of plain send() vs MSG_ZEROCOPY across payload sizes
+//
+// The zerocopy sender owns a small pool of buffers; a buffer is reused only
+// after its completion has been read from the error queue, exactly as the
+// publisher does for frames. The crossover is the smallest payload where
+// zerocopy beats the copy path.
+
+static constexpr size_t BUFFER_POOL = 32;
+static constexpr size_t BYTES_PER_RUN = size_t{256} << 20;  // 256 MB
+
+struct Connection {
+    int sender = -1;
+    int receiver = -1;
+};
+
+static Connection connect_loopback() {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    listen(listener, 1);
+    socklen_t len = sizeof(addr);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+
+    Connection conn;
+    conn.sender = socket(AF_INET, SOCK_STREAM, 0);
+    connect(conn.sender, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    conn.receiver = accept(listener, nullptr, nullptr);
+    close(listener);
+
+    int one = 1;
+    setsockopt(conn.sender, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return conn;
+}
+
+// Receiver side: drain until the expected byte count arrives
+static void drain(int fd, size_t total) {
+    std::vector<char> sink(1 << 20);
+    size_t received = 0;
+    while (received < total) {
+        ssize_t n = recv(fd, sink.data(), sink.size(), 0);
+        if (n <= 0) {
+            return;
+        }
+        received += n;
+    }
+}
+
+static bool send_all(int fd, const char* data, size_t size, int flags, uint32_t& sends) {
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, flags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sends++;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+struct Result {
+    double gbps = 0.0;
+    uint64_t copied = 0;       // Completions the kernel reported as copied
+    uint64_t completions = 0;
+    bool ok = true;
+};
+
+static Result run(size_t payload, bool use_zerocopy) {
+    Connection conn = connect_loopback();
+    if (use_zerocopy && !zerocopy::enable(conn.sender)) {
+        close(conn.sender);
+        close(conn.receiver);
+        return Result{0.0, 0, 0, false};
+    }
+
+    size_t messages = std::max<size_t>(BYTES_PER_RUN / payload, 64);
+    size_t total = messages * payload;
+    std::thread receiver(drain, conn.receiver, total);
+
+    std::vector<std::vector<char>> pool(BUFFER_POOL, std::vector<char>(payload, 'x'));
+    std::vector<uint32_t> last_id(BUFFER_POOL, 0);   // Highest notification ID using each buffer
+    std::vector<bool> busy(BUFFER_POOL, false);
+    uint32_t next_id = 0;
+    uint32_t completed_hi = 0;
+    bool any_completed = false;
+    Result result;
+
+    auto reap = [&](bool block) {
+        if (block) {
+            pollfd pfd{conn.sender, 0, 0};
+            poll(&pfd, 1, 10);
+        }
+        zerocopy::drain_completions(conn.sender, [&](uint32_t, uint32_t hi, bool copied) {
+            completed_hi = hi;
+            any_completed = true;
+            result.completions++;
+            result.copied += copied;
+        });
+        for (size_t i = 0; i < BUFFER_POOL; i++) {
+            if (busy[i] && any_completed && zerocopy::completed(last_id[i], completed_hi)) {
+                busy[i] = false;
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t m = 0; m < messages && result.ok; m++) {
+        size_t slot = m % BUFFER_POOL;
+        if (use_zerocopy) {
+            while (busy[slot]) {
+                reap(true);
+            }
+            uint32_t sends = 0;
+            result.ok = send_all(conn.sender, pool[slot].data(), payload, MSG_ZEROCOPY, sends);
+            next_id += sends;
+            last_id[slot] = next_id - 1;
+            busy[slot] = true;
+        } else {
+            uint32_t sends = 0;
+            result.ok = send_all(conn.sender, pool[slot].data(), payload, 0, sends);
+        }
+    }
+    receiver.join();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    while (use_zerocopy && std::any_of(busy.begin(), busy.end(), [](bool b) { return b; })) {
+        reap(true);
+    }
+
+    result.gbps = total * 8.0 / elapsed / 1e9;
+    close(conn.sender);
+    close(conn.receiver);
+    return result;
+}
+
+int main() {
+    fmt::print("{:>10} {:>12} {:>12} {:>8} {:>14}\n", "payload", "copy Gb/s", "zc Gb/s", "ratio", "zc copied");
+
+    size_t crossover = 0;
+    for (size_t payload = 256; payload <= (size_t{1} << 20); payload *= 2) {
+        Result copy = run(payload, false);
+        Result zc = run(payload, true);
+        if (!zc.ok) {
+            fmt::print("SO_ZEROCOPY unavailable on this kernel\n");
+            return 1;
+        }
+        double ratio = zc.gbps / copy.gbps;
+        fmt::print("{:>10} {:>12.2f} {:>12.2f} {:>8.2f} {:>8}/{:<5}\n",
+            payload, copy.gbps, zc.gbps, ratio, zc.copied, zc.completions);
+        if (crossover == 0 && ratio > 1.0) {
+            crossover = payload;
+        }
+    }
+
+    if (crossover > 0) {
+        fmt::print("\nZerocopy wins from {} bytes; use --zerocopy-threshold {}\n", crossover, crossover);
+    } else {
+        fmt::print("\nZerocopy never won on this path (loopback usually copies anyway)\n");
+    }
+    return 0;
+}
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <fmt/format.h>
+#include "utils.h"
+
+// Asynchronous binary logger for hot loops
+//
+// A log call copies a record header (decoder + format string pointer) and
+// the raw argument bytes into the calling thread's own SPSC byte ring; no
+// formatting and no I/O happen on the caller. A background thread, pinned to
+// a housekeeping core, drains every ring, formats with fmt and writes stdout.
+// If a ring is full the record is dropped and counted, so a stalled terminal
+// or pipe never blocks the producer.
+//
+// Arguments must be trivially copyable. char arrays (e.g. MarketData's
+// instrument) are captured by value; pointers are rejected because the
+// pointee may be gone by the time the record is formatted. Wrap a raw
+// nanosecond timestamp in alog::Timestamp to have it printed as HH:MM:SS.ns.
+//
+// The format is checked against the captured argument types when the call
+// is compiled: pass it as FMT_STRING("...") (C++17; under C++20 a plain
+// literal is checked too). It must be a string literal, since only its
+// pointer is stored.
+
+namespace alog {
+
+template<size_t N>
+struct InlineString {
+    char data[N];
+};
+
+struct Timestamp {
+    uint64_t ns;
+};
+
+namespace detail {
+
+template<typename T>
+struct Capture {
+    static_assert(std::is_trivially_copyable_v<T>, "log arguments must be trivially copyable");
+    static_assert(!std::is_pointer_v<T>, "log arguments must not be pointers; copy strings into the record");
+    using type = T;
+    static const T& from(const T& value) { return value; }
+};
+
+template<size_t N>
+struct Capture<char[N]> {
+    using type = InlineString<N>;
+    static type from(const char (&value)[N]) {
+        type out;
+        std::memcpy(out.data, value, N);
+        return out;
+    }
+};
+
+template<typename T>
+using captured_t = typename Capture<T>::type;
+
+template<typename T>
+T read(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+using DecodeFn = void (*)(const char* format, const char* payload, fmt::memory_buffer& out);
+
+// Throws fmt::format_error if format does not fit Args; the front end
+// checks at compile time, so this is only a backstop
+template<typename... Args>
+void decode(const char* format, [[maybe_unused]] const char* payload, fmt::memory_buffer& out) {
+    // Braced initialization reads the arguments left to right
+    std::tuple<Args...> args{read<Args>(payload)...};
+    std::apply([&](const auto&... values) {
+        fmt::format_to(std::back_inserter(out), fmt::runtime(format), values...);
+    }, args);
+}
+
+struct RecordHeader {
+    DecodeFn decode;        // nullptr: padding to the end of the ring
+    const char* format;
+    uint32_t size;          // Header plus payload, rounded up to 8 bytes
+};
+
+} // namespace detail
+
+// Per-thread byte ring. Records never wrap: one that does not fit before the
+// end is preceded by a padding header and written at offset 0.
+class LogRing {
+public:
+    static constexpr size_t CAPACITY = size_t{1} << 20;
+
+    LogRing() : storage_(new char[CAPACITY]) {}
+
+    template<typename... Args>
+    void write(const char* format, const Args&... args) {
+        using detail::RecordHeader;
+        constexpr size_t payload = (sizeof(detail::captured_t<Args>) + ... + 0);
+        constexpr size_t size = (sizeof(RecordHeader) + payload + 7) & ~size_t{7};
+        static_assert(size <= CAPACITY / 4, "log record too large");
+
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t tail = tail_cache_;
+        size_t offset = head % CAPACITY;
+        size_t padding = CAPACITY - offset < size ? CAPACITY - offset : 0;
+        if (head + padding + size - tail > CAPACITY) {
+            tail = tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head + padding + size - tail > CAPACITY) {
+                dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        if (padding > 0) {
+            // Too little room for a header is skipped implicitly by drain()
+            if (padding >= sizeof(RecordHeader)) {
+                RecordHeader pad{nullptr, nullptr, static_cast<uint32_t>(padding)};
+                std::memcpy(storage_.get() + offset, &pad, sizeof(pad));
+            }
+            head += padding;
+            offset = 0;
+        }
+
+        char* p = storage_.get() + offset;
+        RecordHeader header{&detail::decode<detail::captured_t<Args>...>, format, static_cast<uint32_t>(size)};
+        std::memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        ((store(p, detail::Capture<Args>::from(args))), ...);
+        head_.store(head + size, std::memory_order_release);
+    }
+
+    // Format every published record into out (background thread only)
+    size_t drain(fmt::memory_buffer& out) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        size_t records = 0;
+        while (tail != head) {
+            size_t to_end = CAPACITY - tail % CAPACITY;
+            if (to_end < sizeof(detail::RecordHeader)) {
+                tail += to_end;
+                continue;
+            }
+            detail::RecordHeader header;
+            const char* p = storage_.get() + tail % CAPACITY;
+            std::memcpy(&header, p, sizeof(header));
+            if (header.decode != nullptr) {
+                // A format that slipped past the compile-time check (plain
+                // literal under C++17) fails here; report it in place of the
+                // record rather than let the exception end the process
+                size_t mark = out.size();
+                try {
+                    header.decode(header.format, p + sizeof(header), out);
+                } catch (const fmt::format_error& e) {
+                    std::string_view format(header.format);
+                    if (!format.empty() && format.back() == '\n') {
+                        format.remove_suffix(1);
+                    }
+                    out.resize(mark);
+                    fmt::format_to(std::back_inserter(out), "Error: Bad log format \"{}\": {}\n", format, e.what());
+                }
+                records++;
+            }
+            tail += header.size;
+        }
+        tail_.store(tail, std::memory_order_release);
+        return records;
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    template<typename T>
+    static void store(char*& p, const T& value) {
+        std::memcpy(p, &value, sizeof(T));
+        p += sizeof(T);
+    }
+
+    // Producer side
+    alignas(64) std::atomic<uint64_t> head_{0};
+    uint64_t tail_cache_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+    // Consumer side
+    alignas(64) std::atomic<uint64_t> tail_{0};
+
+    std::unique_ptr<char[]> storage_;
+};
+
+class AsyncLogger {
+public:
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    // Start the background thread; returns false if it could not be
+    // pinned to cpu_id (it still runs, unpinned)
+    bool start(int cpu_id) {
+        running_.store(true, std::memory_order_relaxed);
+        thread_ = std::thread([this] { run(); });
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu_id, &cpuset);
+        return pthread_setaffinity_np(thread_.native_handle(), sizeof(cpu_set_t), &cpuset) == 0;
+    }
+
+    // Drain everything logged so far and join the background thread
+    void stop() {
+        if (thread_.joinable()) {
+            running_.store(false, std::memory_order_relaxed);
+            thread_.join();
+        }
+    }
+
+    template<typename... Args>
+    void log(fmt::format_string<detail::captured_t<Args>...> format, const Args&... args) {
+        thread_ring().write(fmt::string_view(format).data(), args...);
+    }
+
+    uint64_t dropped() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t total = 0;
+        for (const auto& ring : rings_) {
+            total += ring->dropped();
+        }
+        return total;
+    }
+
+private:
+    AsyncLogger() = default;
+    ~AsyncLogger() { stop(); }
+
+    LogRing& thread_ring() {
+        thread_local LogRing* ring = nullptr;
+        if (ring == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.push_back(std::make_unique<LogRing>());
+            ring = rings_.back().get();
+        }
+        return *ring;
+    }
+
+    // Returns the number of records written
+    size_t flush(fmt::memory_buffer& out) {
+        size_t records = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& ring : rings_) {
+                records += ring->drain(out);
+            }
+        }
+        if (out.size() > 0) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::fflush(stdout);
+            out.clear();
+        }
+        return records;
+    }
+
+    void run() {
+        fmt::memory_buffer out;
+        while (running_.load(std::memory_order_relaxed)) {
+            if (flush(out) == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        flush(out);
+    }
+
+    std::mutex mutex_;  // Guards rings_ (registration is rare)
+    std::vector<std::unique_ptr<LogRing>> rings_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+template<typename... Args>
+inline void log(fmt::format_string<detail::captured_t<Args>...> format, const Args&... args) {
+    AsyncLogger::instance().log<Args...>(format, args...);
+}
+
+} // namespace alog
+
+template<size_t N>
+struct fmt::formatter<alog::InlineString<N>> : fmt::formatter<std::string_view> {
+    template<typename FormatContext>
+    auto format(const alog::InlineString<N>& value, FormatContext& ctx) const {
+        return fmt::formatter<std::string_view>::format(std::string_view(value.data, strnlen(value.data, N)), ctx);
+    }
+};
+
+template<>
+struct fmt::formatter<alog::Timestamp> : fmt::formatter<std::string_view> {
+    template<typename FormatContext>
+    auto format(const alog::Timestamp& value, FormatContext& ctx) const {
+        char buffer[utils::TIMESTAMP_SIZE];
+        utils::format_timestamp(value.ns, buffer);
+        return fmt::formatter<std::string_view>::format(std::string_view(buffer, sizeof(buffer)), ctx);
+    }
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "market_data.h"
+
+// Append-only capture file for the shm feed
+//
+// A 64-byte header followed by fixed-size records, each one MarketData plus
+// the time the recorder popped it. The writer maps the file and grows it a
+// chunk at a time (64 MB): each chunk is allocated up front, records are
+// copied straight into the mapping, and a finished chunk is handed to the
+// kernel for writeback, so the hot path never calls write() and the disk
+// sees large sequential writes. The header's record count is updated after
+// every append, so a capture cut short by a crash is still readable.
+
+namespace capture {
+
+static constexpr char MAGIC[8] = {'M', 'D', 'C', 'A', 'P', 'T', 'R', '\0'};
+static constexpr uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;    // sizeof(Record) of the writer
+    uint64_t count;          // Records written
+    uint64_t reserved[5];
+};
+
+struct Record {
+    MarketData data;         // As pushed by the publisher (timestamp_ns = publish time)
+    uint64_t recv_ts;        // When the recorder popped it
+};
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader must stay one cache line");
+static_assert(std::is_trivially_copyable<Record>::value, "Record is copied into the mapping");
+
+class CaptureWriter {
+public:
+    static constexpr size_t CHUNK_BYTES = size_t{64} << 20;
+
+    explicit CaptureWriter(const char* path) {
+        fd_ = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ == -1) {
+            throw std::runtime_error("Failed to create capture file: " + std::string(strerror(errno)));
+        }
+        grow();
+        header_ = reinterpret_cast<FileHeader*>(base_);
+        std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+        header_->version = VERSION;
+        header_->record_size = sizeof(Record);
+        header_->count = 0;
+    }
+
+    ~CaptureWriter() { close(); }
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    void append(const MarketData& data, uint64_t recv_ts) {
+        size_t offset = sizeof(FileHeader) + count_ * sizeof(Record);
+        if (offset + sizeof(Record) > mapped_) {
+            grow();
+        }
+        Record* record = reinterpret_cast<Record*>(base_ + offset);
+        record->data = data;
+        record->recv_ts = recv_ts;
+        header_->count = ++count_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t bytes() const { return sizeof(FileHeader) + count_ * sizeof(Record); }
+
+    // Trim the file to the records written and unmap it. On failure the
+    // file keeps zeroed space past the last record; readers go by the header.
+    bool close() {
+        if (fd_ == -1) {
+            return true;
+        }
+        munmap(base_, mapped_);
+        bool trimmed = ftruncate(fd_, static_cast<off_t>(bytes())) == 0;
+        ::close(fd_);
+        fd_ = -1;
+        return trimmed;
+    }
+
+private:
+    // Extend the file and the mapping by one chunk
+    void grow() {
+        size_t size = mapped_ + CHUNK_BYTES;
+        int err = posix_fallocate(fd_, 0, static_cast<off_t>(size));
+        if (err != 0) {
+            throw std::runtime_error("Failed to extend capture file: " + std::string(strerror(err)));
+        }
+
+        void* addr = base_ == nullptr
+            ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)
+            : mremap(base_, mapped_, size, MREMAP_MAYMOVE);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("Failed to map capture file: " + std::string(strerror(errno)));
+        }
+        if (base_ != nullptr) {
+            // Start writeback of the chunk just filled instead of letting
+            // dirty pages pile up until exit
+            sync_file_range(fd_, static_cast<off_t>(mapped_ - CHUNK_BYTES), CHUNK_BYTES, SYNC_FILE_RANGE_WRITE);
+        }
+        base_ = static_cast<char*>(addr);
+        header_ = reinterpret_cast<FileHeader*>(base_);
+        madvise(base_ + mapped_, CHUNK_BYTES, MADV_SEQUENTIAL);
+        mapped_ = size;
+    }
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t mapped_ = 0;
+    FileHeader* header_ = nullptr;
+    uint64_t count_ = 0;
+};
+
+// Read-only view of a capture
+class CaptureReader {
+public:
+    explicit CaptureReader(const char* path) {
+        int fd = open(path, O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("Failed to open capture file: " + std::string(strerror(errno)));
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Not a capture file (too short)");
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("Failed to map capture file: " + std::string(strerror(errno)));
+        }
+        base_ = static_cast<const char*>(addr);
+
+        const FileHeader* header = reinterpret_cast<const FileHeader*>(base_);
+        if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+            header->record_size != sizeof(Record)) {
+            munmap(const_cast<char*>(base_), size_);
+            throw std::runtime_error("Not a capture file (bad header)");
+        }
+        count_ = std::min<uint64_t>(header->count, (size_ - sizeof(FileHeader)) / sizeof(Record));
+        madvise(const_cast<char*>(base_), size_, MADV_SEQUENTIAL);
+    }
+
+    ~CaptureReader() { munmap(const_cast<char*>(base_), size_); }
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    uint64_t count() const { return count_; }
+
+    const Record& operator[](uint64_t i) const {
+        return reinterpret_cast<const Record*>(base_ + sizeof(FileHeader))[i];
+    }
+
+private:
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    uint64_t count_ = 0;
+};
+
+} // namespace capture
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "market_data.h"
+#include "instruments.h"
+
+// Compact binary encoding for the TCP feed
+//
+// Frame: [tag:1][len:1][payload:len]
+// Tags have the high bit set, so a frame can never be mistaken for a JSON
+// line (which always starts with '{') and both can share one stream.
+//
+// KEYFRAME payload: id, seq, bid_ticks, ask_ticks, timestamp_ns (absolute)
+// DELTA payload:    id, seq delta, bid delta, ask delta, timestamp delta
+//
+// Unsigned fields are LEB128 varints; signed fields are zig-zag varints.
+// Price deltas are against the previous quote for the same instrument on
+// this connection; seq and timestamp deltas are against the previous frame
+// on this connection. Each instrument gets a keyframe on its first update and
+// every KEYFRAME_INTERVAL updates after that so a decoder can resync.
+
+namespace codec {
+
+static constexpr uint8_t TAG_KEYFRAME = 0x80;
+static constexpr uint8_t TAG_DELTA = 0x81;
+static constexpr size_t HEADER_SIZE = 2;
+static constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + 5 * 10;
+static constexpr uint32_t KEYFRAME_INTERVAL = 100;
+
+inline bool is_compact_tag(uint8_t byte) {
+    return byte == TAG_KEYFRAME || byte == TAG_DELTA;
+}
+
+inline int64_t to_ticks(double price) {
+    return std::llround(price / instruments::TICK_SIZE);
+}
+
+inline double from_ticks(int64_t ticks) {
+    return static_cast<double>(ticks) * instruments::TICK_SIZE;
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline uint8_t* put_varint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+// Returns nullptr if the varint runs past end
+inline const uint8_t* get_varint(const uint8_t* in, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return in;
+        }
+    }
+    return nullptr;
+}
+
+// Per-connection codec state; the encoder and decoder keep identical copies
+struct CodecState {
+    struct InstrumentState {
+        int64_t bid_ticks = 0;
+        int64_t ask_ticks = 0;
+        uint32_t since_keyframe = 0;
+        bool valid = false;
+    };
+
+    std::array<InstrumentState, instruments::COUNT> instruments{};
+    uint64_t last_seq = 0;
+    uint64_t last_timestamp_ns = 0;
+
+    void reset() { *this = CodecState{}; }
+};
+
+class Encoder {
+public:
+    // Append one frame for data to out
+    void encode(const MarketData& data, std::string& out) {
+        uint8_t frame[MAX_FRAME_SIZE];
+        size_t size = encode(data, frame);
+        out.append(reinterpret_cast<const char*>(frame), size);
+    }
+
+    // Write one frame into frame (at least MAX_FRAME_SIZE bytes), returning its size
+    size_t encode(const MarketData& data, uint8_t* frame) {
+        uint8_t* p = frame + HEADER_SIZE;
+
+        auto& inst = state_.instruments[data.instrument_id];
+        int64_t bid = to_ticks(data.bid);
+        int64_t ask = to_ticks(data.ask);
+
+        p = put_varint(p, data.instrument_id);
+        if (!inst.valid || inst.since_keyframe >= KEYFRAME_INTERVAL) {
+            frame[0] = TAG_KEYFRAME;
+            p = put_varint(p, data.seq_num);
+            p = put_varint(p, zigzag(bid));
+            p = put_varint(p, zigzag(ask));
+            p = put_varint(p, data.timestamp_ns);
+            inst.valid = true;
+            inst.since_keyframe = 0;
+        } else {
+            frame[0] = TAG_DELTA;
+            p = put_varint(p, data.seq_num - state_.last_seq);
+            p = put_varint(p, zigzag(bid - inst.bid_ticks));
+            p = put_varint(p, zigzag(ask - inst.ask_ticks));
+            p = put_varint(p, zigzag(static_cast<int64_t>(data.timestamp_ns - state_.last_timestamp_ns)));
+            inst.since_keyframe++;
+        }
+        inst.bid_ticks = bid;
+        inst.ask_ticks = ask;
+        state_.last_seq = data.seq_num;
+        state_.last_timestamp_ns = data.timestamp_ns;
+
+        frame[1] = static_cast<uint8_t>(p - frame - HEADER_SIZE);
+        return p - frame;
+    }
+
+    // Forget all history; the next update per instrument is a keyframe
+    void reset() { state_.reset(); }
+
+private:
+    CodecState state_;
+};
+
+class Decoder {
+public:
+    // Decode one complete frame (header included). Returns false on a
+    // malformed frame or a delta for an instrument that has no keyframe yet.
+    bool decode(const uint8_t* frame, size_t size, MarketData& data) {
+        if (size < HEADER_SIZE || size != HEADER_SIZE + frame[1]) {
+            return false;
+        }
+        const uint8_t* p = frame + HEADER_SIZE;
+        const uint8_t* end = frame + size;
+        uint64_t id, seq, bid, ask, ts;
+        if (!(p = get_varint(p, end, id)) || id >= instruments::COUNT ||
+            !(p = get_varint(p, end, seq)) ||
+            !(p = get_varint(p, end, bid)) ||
+            !(p = get_varint(p, end, ask)) ||
+            !(p = get_varint(p, end, ts))) {
+            return false;
+        }
+
+        auto& inst = state_.instruments[id];
+        if (frame[0] == TAG_KEYFRAME) {
+            inst.bid_ticks = unzigzag(bid);
+            inst.ask_ticks = unzigzag(ask);
+            inst.valid = true;
+            state_.last_seq = seq;
+            state_.last_timestamp_ns = ts;
+        } else {
+            if (!inst.valid) {
+                return false;
+            }
+            inst.bid_ticks += unzigzag(bid);
+            inst.ask_ticks += unzigzag(ask);
+            state_.last_seq += seq;
+            state_.last_timestamp_ns += unzigzag(ts);
+        }
+
+        std::memset(data.instrument, 0, sizeof(data.instrument));
+        std::strncpy(data.instrument, instruments::UNIVERSE[id].symbol, sizeof(data.instrument) - 1);
+        data.instrument_id = static_cast<uint32_t>(id);
+        data.bid = from_ticks(inst.bid_ticks);
+        data.ask = from_ticks(inst.ask_ticks);
+        data.seq_num = state_.last_seq;
+        data.timestamp_ns = state_.last_timestamp_ns;
+        return true;
+    }
+
+private:
+    CodecState state_;
+};
+
+} // namespace codec
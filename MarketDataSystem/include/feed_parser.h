@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "market_data.h"
+#include "compact_codec.h"
+#include "recv_buffer.h"
+#include "utils.h"
+
+// Incremental frame parser for the TCP feed
+//
+// Works directly on the bytes in a RecvBuffer: it finds the next frame
+// boundary (a compact frame's length byte or a JSON line's newline), decodes
+// the frame where it lies and consumes it. An incomplete frame is left in the
+// buffer for the next recv. Nothing is copied into an intermediate string and
+// nothing is allocated per message; the decoded update is reused and handed
+// out by reference.
+
+namespace feed {
+
+enum class FrameType {
+    NEED_MORE,      // No complete frame buffered
+    UPDATE,         // data() holds the update
+    SNAPSHOT,       // snapshot_seq() / snapshot_count() hold the header
+    BAD_COMPACT,    // Undecodable compact frame (no keyframe yet)
+    BAD_JSON,       // Unparseable line; see bad_frame()
+};
+
+class FeedParser {
+public:
+    // Decode and consume the frame at the head of buffer
+    FrameType next(RecvBuffer& buffer) {
+        size_t available = buffer.size();
+        if (available == 0) {
+            return FrameType::NEED_MORE;
+        }
+        const char* frame = buffer.data();
+
+        if (resyncing_) {
+            const char* newline = static_cast<const char*>(std::memchr(frame, '\n', available));
+            if (newline == nullptr) {
+                buffer.consume(available);
+                return FrameType::NEED_MORE;
+            }
+            buffer.consume(newline - frame + 1);
+            resyncing_ = false;
+            return next(buffer);
+        }
+
+        if (codec::is_compact_tag(static_cast<uint8_t>(frame[0]))) {
+            if (available < codec::HEADER_SIZE) {
+                return FrameType::NEED_MORE;
+            }
+            size_t frame_size = codec::HEADER_SIZE + static_cast<uint8_t>(frame[1]);
+            if (available < frame_size) {
+                return FrameType::NEED_MORE;
+            }
+            bool decoded = decoder_.decode(reinterpret_cast<const uint8_t*>(frame), frame_size, data_);
+            buffer.consume(frame_size);
+            return decoded ? FrameType::UPDATE : FrameType::BAD_COMPACT;
+        }
+
+        const char* newline = static_cast<const char*>(std::memchr(frame, '\n', available));
+        if (newline == nullptr) {
+            return FrameType::NEED_MORE;
+        }
+        size_t line_size = newline - frame;
+        buffer.consume(line_size + 1);
+
+        if (utils::from_json(frame, line_size, data_)) {
+            return FrameType::UPDATE;
+        }
+        if (utils::parse_snapshot_header(frame, line_size, snapshot_seq_, snapshot_count_)) {
+            return FrameType::SNAPSHOT;
+        }
+        bad_frame_ = frame;
+        bad_frame_size_ = line_size;
+        return FrameType::BAD_JSON;
+    }
+
+    // Drop a partial line that fills the whole buffer and cannot complete;
+    // the rest of it is skipped as it arrives, up to the next newline.
+    // Compact frames are at most HEADER_SIZE + 255 bytes, so only a JSON
+    // line can get here.
+    void discard_oversized(RecvBuffer& buffer) {
+        buffer.consume(buffer.size());
+        resyncing_ = true;
+    }
+
+    const MarketData& data() const { return data_; }
+    uint64_t snapshot_seq() const { return snapshot_seq_; }
+    uint32_t snapshot_count() const { return snapshot_count_; }
+
+    // The rejected line; valid until the buffer is written again
+    const char* bad_frame() const { return bad_frame_; }
+    size_t bad_frame_size() const { return bad_frame_size_; }
+
+private:
+    codec::Decoder decoder_;
+    MarketData data_;
+    uint64_t snapshot_seq_ = 0;
+    uint32_t snapshot_count_ = 0;
+    const char* bad_frame_ = nullptr;
+    size_t bad_frame_size_ = 0;
+    bool resyncing_ = false;     // Skipping the tail of an oversized line
+};
+
+} // namespace feed
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Refcounted immutable frames for TCP fan-out
+//
+// A message is serialized once into a Frame; every session that sends it
+// holds a FrameRef until its write completes, and the last release returns
+// the frame to its pool. Frames come from power-of-two size classes with a
+// free list each, so steady-state fan-out allocates nothing.
+//
+// Not thread-safe: frames are created, shared and released on the
+// io_context thread only.
+
+class FramePool;
+
+struct Frame {
+    FramePool* pool;
+    uint32_t refs;
+    uint32_t size;          // Bytes written
+    uint32_t capacity;      // Bytes available in data()
+    uint32_t size_class;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+class FrameRef {
+public:
+    FrameRef() = default;
+    explicit FrameRef(Frame* frame) : frame_(frame) {}
+
+    FrameRef(const FrameRef& other) : frame_(other.frame_) {
+        if (frame_ != nullptr) {
+            frame_->refs++;
+        }
+    }
+
+    FrameRef(FrameRef&& other) noexcept : frame_(std::exchange(other.frame_, nullptr)) {}
+
+    FrameRef& operator=(FrameRef other) noexcept {
+        std::swap(frame_, other.frame_);
+        return *this;
+    }
+
+    ~FrameRef() { reset(); }
+
+    inline void reset();
+
+    Frame* operator->() const { return frame_; }
+    Frame& operator*() const { return *frame_; }
+    explicit operator bool() const { return frame_ != nullptr; }
+
+private:
+    Frame* frame_ = nullptr;
+};
+
+class FramePool {
+public:
+    static constexpr uint32_t MIN_CLASS_BITS = 7;   // 128 bytes
+    static constexpr uint32_t NUM_CLASSES = 16;     // Up to 4 MB
+
+    // Warm the classes that frames of the given sizes land in (the caller's
+    // single-message frames) with prealloc frames each, so fan-out does not
+    // allocate while those lists fill up
+    explicit FramePool(std::initializer_list<size_t> warm_sizes, size_t prealloc = 4096) {
+        for (size_t size : warm_sizes) {
+            uint32_t size_class = class_for(size);
+            if (size_class >= NUM_CLASSES || !free_lists_[size_class].empty()) {
+                continue;
+            }
+            free_lists_[size_class].reserve(prealloc);
+            for (size_t i = 0; i < prealloc; i++) {
+                free_lists_[size_class].push_back(allocate(size_class));
+            }
+        }
+    }
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    ~FramePool() {
+        for (auto& list : free_lists_) {
+            for (Frame* frame : list) {
+                ::operator delete(frame);
+            }
+        }
+    }
+
+    // Get an empty frame with room for at least capacity bytes
+    FrameRef acquire(size_t capacity) {
+        uint32_t size_class = class_for(capacity);
+        Frame* frame;
+        if (size_class >= NUM_CLASSES) {
+            frame = allocate_bytes(capacity, size_class);
+        } else if (!free_lists_[size_class].empty()) {
+            frame = free_lists_[size_class].back();
+            free_lists_[size_class].pop_back();
+        } else {
+            frame = allocate(size_class);
+        }
+        frame->refs = 1;
+        frame->size = 0;
+        return FrameRef(frame);
+    }
+
+    void release(Frame* frame) {
+        if (frame->size_class >= NUM_CLASSES) {
+            ::operator delete(frame);
+        } else {
+            free_lists_[frame->size_class].push_back(frame);
+        }
+    }
+
+private:
+    static uint32_t class_for(size_t capacity) {
+        uint32_t size_class = 0;
+        while ((size_t{1} << (size_class + MIN_CLASS_BITS)) < capacity) {
+            size_class++;
+        }
+        return size_class;
+    }
+
+    Frame* allocate(uint32_t size_class) {
+        return allocate_bytes(size_t{1} << (size_class + MIN_CLASS_BITS), size_class);
+    }
+
+    Frame* allocate_bytes(size_t capacity, uint32_t size_class) {
+        void* memory = ::operator new(sizeof(Frame) + capacity);
+        Frame* frame = static_cast<Frame*>(memory);
+        frame->pool = this;
+        frame->refs = 0;
+        frame->size = 0;
+        frame->capacity = static_cast<uint32_t>(capacity);
+        frame->size_class = size_class;
+        return frame;
+    }
+
+    std::array<std::vector<Frame*>, NUM_CLASSES> free_lists_;
+};
+
+inline void FrameRef::reset() {
+    if (frame_ != nullptr && --frame_->refs == 0) {
+        frame_->pool->release(frame_);
+    }
+    frame_ = nullptr;
+}
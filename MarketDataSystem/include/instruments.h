@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Static instrument universe shared by the publisher and consumers.
+// The index into UNIVERSE is the instrument ID used on every transport.
+
+namespace instruments {
+
+struct Instrument {
+    const char* symbol;
+    double base_price;
+};
+
+static constexpr Instrument UNIVERSE[] = {
+    {"RELIANCE",  2850.0},
+    {"TCS",       3900.0},
+    {"INFY",      1500.0},
+    {"HDFCBANK",  1650.0},
+    {"ICICIBANK", 1100.0},
+    {"SBIN",       780.0},
+    {"ITC",        450.0},
+    {"LT",        3600.0},
+};
+
+static constexpr uint32_t COUNT = sizeof(UNIVERSE) / sizeof(UNIVERSE[0]);
+static constexpr double TICK_SIZE = 0.01;  // Price grid for every instrument
+static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+// Look up an instrument ID by symbol (INVALID_ID if unknown)
+inline uint32_t find(const char* symbol) {
+    for (uint32_t id = 0; id < COUNT; id++) {
+        if (std::strcmp(UNIVERSE[id].symbol, symbol) == 0) {
+            return id;
+        }
+    }
+    return INVALID_ID;
+}
+
+// Instrument sets (subscriptions, dirty-sets) are 64-bit masks
+static_assert(COUNT <= 64, "Instrument masks are 64 bits wide");
+
+// Bit mask with one bit per instrument ID
+static constexpr uint64_t ALL_MASK =
+    COUNT >= 64 ? ~uint64_t{0} : (uint64_t{1} << COUNT) - 1;
+
+// Parse a comma-separated symbol list ("RELIANCE,TCS" or "*") into a mask.
+// Returns false if any symbol is unknown.
+inline bool parse_symbol_list(const char* list, uint64_t& mask) {
+    mask = 0;
+    if (std::strcmp(list, "*") == 0) {
+        mask = ALL_MASK;
+        return true;
+    }
+    char symbol[16];
+    size_t len = 0;
+    for (const char* p = list; ; p++) {
+        if (*p == ',' || *p == '\0') {
+            symbol[len] = '\0';
+            uint32_t id = find(symbol);
+            if (id == INVALID_ID) {
+                return false;
+            }
+            mask |= uint64_t{1} << id;
+            len = 0;
+            if (*p == '\0') {
+                break;
+            }
+        } else if (len < sizeof(symbol) - 1) {
+            symbol[len++] = *p;
+        }
+    }
+    return true;
+}
+
+} // namespace instruments
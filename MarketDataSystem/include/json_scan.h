@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JSON_SCAN_X86 1
+#endif
+
+// Vectorized structural scan for one JSON message
+//
+// Marks every '"', ',', ':' and '}' in a line as a bit in a small bitmap, so
+// the parser can jump from a field to the end of its value instead of
+// testing one byte at a time. Lines are at most MAX_LINE bytes (the feed's
+// messages are well under that).
+//
+// AVX2 compares 32 bytes per step and SSE2 16; the implementation is picked
+// once at startup with __builtin_cpu_supports. The final partial block is
+// copied into a zeroed buffer so no load touches memory past the line.
+
+namespace json_scan {
+
+static constexpr size_t WORDS = 3;
+static constexpr size_t MAX_LINE = WORDS * 64;
+
+struct Structurals {
+    uint64_t bits[WORDS];
+
+    // Position of the first structural at or after pos, or MAX_LINE if none
+    size_t next(size_t pos) const {
+        for (size_t w = pos / 64; w < WORDS; w++) {
+            uint64_t word = bits[w];
+            if (w == pos / 64) {
+                word &= ~uint64_t{0} << (pos % 64);
+            }
+            if (word != 0) {
+                return w * 64 + static_cast<size_t>(__builtin_ctzll(word));
+            }
+        }
+        return MAX_LINE;
+    }
+};
+
+inline bool is_structural(char c) {
+    return c == '"' || c == ',' || c == ':' || c == '}';
+}
+
+inline void scan_scalar(const char* line, size_t len, Structurals& out) {
+    std::memset(out.bits, 0, sizeof(out.bits));
+    for (size_t i = 0; i < len; i++) {
+        if (is_structural(line[i])) {
+            out.bits[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+}
+
+#ifdef JSON_SCAN_X86
+
+inline void scan_sse2(const char* line, size_t len, Structurals& out) {
+    std::memset(out.bits, 0, sizeof(out.bits));
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i brace = _mm_set1_epi8('}');
+    alignas(16) char tail[16];
+
+    for (size_t i = 0; i < len; i += 16) {
+        const char* block = line + i;
+        if (len - i < 16) {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, block, len - i);
+            block = tail;
+        }
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, comma)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, brace)));
+        uint64_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        out.bits[i / 64] |= mask << (i % 64);
+    }
+}
+
+__attribute__((target("avx2")))
+inline void scan_avx2(const char* line, size_t len, Structurals& out) {
+    std::memset(out.bits, 0, sizeof(out.bits));
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i brace = _mm256_set1_epi8('}');
+    alignas(32) char tail[32];
+
+    for (size_t i = 0; i < len; i += 32) {
+        const char* block = line + i;
+        if (len - i < 32) {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, block, len - i);
+            block = tail;
+        }
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, comma)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, brace)));
+        uint64_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        out.bits[i / 64] |= mask << (i % 64);
+    }
+}
+
+#endif
+
+using ScanFn = void (*)(const char*, size_t, Structurals&);
+
+inline ScanFn select_scan() {
+#ifdef JSON_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return scan_avx2;
+    }
+    return scan_sse2;
+#else
+    return scan_scalar;
+#endif
+}
+
+inline const char* scan_name() {
+#ifdef JSON_SCAN_X86
+    if (select_scan() == scan_avx2) {
+        return "avx2";
+    }
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+// Scan len bytes (len <= MAX_LINE) with the best implementation for this CPU
+inline void scan(const char* line, size_t len, Structurals& out) {
+    static const ScanFn impl = select_scan();
+    impl(line, len, out);
+}
+
+} // namespace json_scan
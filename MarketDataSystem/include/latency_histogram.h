@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <fmt/format.h>
+
+// Fixed-memory log-linear latency histogram (HDR-style)
+//
+// Values below SUB_BUCKETS nanoseconds get one bucket each. Above that every
+// power of two is split into SUB_BUCKETS / 2 equal buckets, so a recorded
+// value is off by at most 1/128 (< 0.8%) of itself. Values up to 2^42 ns
+// (about 73 minutes) are tracked; anything larger lands in the last bucket,
+// while max() stays exact. Recording is a few shifts and an increment; the
+// counts array is part of the object, so nothing is allocated.
+
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BITS = 8;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BITS;
+    static constexpr uint32_t MAX_BITS = 42;
+    static constexpr size_t BUCKETS = SUB_BUCKETS + (MAX_BITS - SUB_BITS) * (SUB_BUCKETS / 2);
+
+    struct Percentiles {
+        uint64_t count;
+        uint64_t p50, p90, p99, p999, p9999, max;
+    };
+
+    void record(uint64_t value_ns) {
+        counts_[index_of(value_ns)]++;
+        total_++;
+        sum_ += value_ns;
+        max_ = std::max(max_, value_ns);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; i++) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() { *this = LatencyHistogram{}; }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+    uint64_t mean() const { return total_ > 0 ? sum_ / total_ : 0; }
+
+    // Smallest bucket upper edge covering percentile% of the samples,
+    // capped at the exact max
+    uint64_t value_at_percentile(double percentile) const {
+        if (total_ == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total_ + 0.5);
+        target = std::clamp<uint64_t>(target, 1, total_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += counts_[i];
+            if (seen >= target) {
+                return std::min(highest_in_bucket(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    Percentiles percentiles() const {
+        return Percentiles{total_,
+            value_at_percentile(50.0), value_at_percentile(90.0), value_at_percentile(99.0),
+            value_at_percentile(99.9), value_at_percentile(99.99), max_};
+    }
+
+    // Text dump: a header line, then "lowest_value count" for every
+    // non-empty bucket. load() accepts the same format, so dumps from
+    // several runs can be merged (see hist_tool).
+    bool dump(const char* path) const {
+        FILE* file = std::fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+        std::fprintf(file, "# latency_histogram v1 total %" PRIu64 " sum %" PRIu64 " max %" PRIu64 "\n",
+            total_, sum_, max_);
+        for (size_t i = 0; i < BUCKETS; i++) {
+            if (counts_[i] != 0) {
+                std::fprintf(file, "%" PRIu64 " %" PRIu64 "\n", lowest_in_bucket(i), counts_[i]);
+            }
+        }
+        return std::fclose(file) == 0;
+    }
+
+    bool load(const char* path) {
+        FILE* file = std::fopen(path, "r");
+        if (file == nullptr) {
+            return false;
+        }
+        reset();
+        uint64_t total, sum, max;
+        bool ok = std::fscanf(file, "# latency_histogram v1 total %" SCNu64 " sum %" SCNu64 " max %" SCNu64 "\n",
+            &total, &sum, &max) == 3;
+        uint64_t value, count;
+        while (ok && std::fscanf(file, "%" SCNu64 " %" SCNu64 "\n", &value, &count) == 2) {
+            counts_[index_of(value)] += count;
+        }
+        std::fclose(file);
+        total_ = total;
+        sum_ = sum;
+        max_ = max;
+        return ok;
+    }
+
+private:
+    static size_t index_of(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        uint32_t msb = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+        if (msb >= MAX_BITS) {
+            return BUCKETS - 1;
+        }
+        uint32_t shift = msb - (SUB_BITS - 1);
+        uint64_t top = value >> shift;  // In [SUB_BUCKETS / 2, SUB_BUCKETS)
+        return SUB_BUCKETS + (shift - 1) * (SUB_BUCKETS / 2) + (top - SUB_BUCKETS / 2);
+    }
+
+    static uint64_t lowest_in_bucket(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint64_t shift = (index - SUB_BUCKETS) / (SUB_BUCKETS / 2) + 1;
+        uint64_t top = (index - SUB_BUCKETS) % (SUB_BUCKETS / 2) + SUB_BUCKETS / 2;
+        return top << shift;
+    }
+
+    static uint64_t highest_in_bucket(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint64_t shift = (index - SUB_BUCKETS) / (SUB_BUCKETS / 2) + 1;
+        return lowest_in_bucket(index) + (uint64_t{1} << shift) - 1;
+    }
+
+    std::array<uint64_t, BUCKETS> counts_{};
+    uint64_t total_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+template<>
+struct fmt::formatter<LatencyHistogram::Percentiles> {
+    constexpr auto parse(format_parse_context& ctx) { return ctx.begin(); }
+
+    template<typename FormatContext>
+    auto format(const LatencyHistogram::Percentiles& p, FormatContext& ctx) const {
+        return fmt::format_to(ctx.out(),
+            "n={} p50={} p90={} p99={} p99.9={} p99.99={} max={} ns",
+            p.count, p.p50, p.p90, p.p99, p.p999, p.p9999, p.max);
+    }
+};
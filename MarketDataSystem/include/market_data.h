@@ -9,13 +9,15 @@ struct MarketData {
     double bid;              // Bid price
     double ask;              // Ask price
     uint64_t timestamp_ns;   // Nanosecond timestamp
+    uint64_t seq_num;        // Publisher sequence number (gap-free across instruments)
+    uint32_t instrument_id;  // Index into instruments::UNIVERSE
 
-    MarketData() : bid(0.0), ask(0.0), timestamp_ns(0) {
+    MarketData() : bid(0.0), ask(0.0), timestamp_ns(0), seq_num(0), instrument_id(0) {
         std::memset(instrument, 0, sizeof(instrument));
     }
 
     MarketData(const char* instr, double b, double a, uint64_t ts)
-        : bid(b), ask(a), timestamp_ns(ts) {
+        : bid(b), ask(a), timestamp_ns(ts), seq_num(0), instrument_id(0) {
         std::memset(instrument, 0, sizeof(instrument));
         std::strncpy(instrument, instr, sizeof(instrument) - 1);
     }
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Persistent receive buffer for a stream socket
+//
+// recv() appends at the tail and the frame parser consumes from the head.
+// A partial frame left at the head is moved to the front only when the tail
+// runs short of room, so the storage is allocated once and reused for the
+// life of the connection.
+
+class RecvBuffer {
+public:
+    explicit RecvBuffer(size_t capacity = 1 << 16) : storage_(capacity) {}
+
+    const char* data() const { return storage_.data() + head_; }
+    size_t size() const { return tail_ - head_; }
+
+    // Free space after the tail; compacts first if less than min_space remains
+    char* write_ptr(size_t min_space = 4096) {
+        if (storage_.size() - tail_ < min_space) {
+            compact();
+        }
+        return storage_.data() + tail_;
+    }
+    size_t write_space() const { return storage_.size() - tail_; }
+
+    void commit(size_t n) { tail_ += n; }
+
+    void consume(size_t n) {
+        head_ += n;
+        if (head_ == tail_) {
+            head_ = tail_ = 0;
+        }
+    }
+
+private:
+    void compact() {
+        std::memmove(storage_.data(), storage_.data() + head_, tail_ - head_);
+        tail_ -= head_;
+        head_ = 0;
+    }
+
+    std::vector<char> storage_;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+};
@@ -2,26 +2,30 @@
 
 #include <atomic>
 #include <cstdint>
+#include <type_traits>
 #include "market_data.h"
 
 // Lock-free SPSC (Single Producer Single Consumer) Ring Buffer
-// Uses cache-line padding to avoid false sharing
+// Uses cache-line padding to avoid false sharing. RingBuffer is the
+// MarketData instance placed in shared memory; SpscRing also serves as an
+// in-process queue between pinned threads.
 
 static constexpr uint32_t RING_BUFFER_CAPACITY = 1024;
 
-struct RingBuffer {
+template<typename T, uint32_t Capacity>
+struct SpscRing {
     // Cache-line padding to avoid false sharing between producer and consumer
     alignas(64) std::atomic<uint32_t> pushPtr{0};
     alignas(64) std::atomic<uint32_t> popPtr{0};
 
-    MarketData buffer[RING_BUFFER_CAPACITY];
+    T buffer[Capacity];
 
     // Push data into the ring buffer (called by producer)
-    bool push(const MarketData& data) {
+    bool push(const T& data) {
         uint32_t push = pushPtr.load(std::memory_order_relaxed);
         uint32_t pop = popPtr.load(std::memory_order_acquire);
 
-        uint32_t next = (push + 1) % RING_BUFFER_CAPACITY;
+        uint32_t next = (push + 1) % Capacity;
         if (next == pop) {
             return false;  // Buffer full
         }
@@ -32,7 +36,7 @@ struct RingBuffer {
     }
 
     // Pop data from the ring buffer (called by consumer)
-    bool pop(MarketData& data) {
+    bool pop(T& data) {
         uint32_t pop = popPtr.load(std::memory_order_relaxed);
         uint32_t push = pushPtr.load(std::memory_order_acquire);
 
@@ -41,7 +45,7 @@ struct RingBuffer {
         }
 
         data = buffer[pop];
-        uint32_t next = (pop + 1) % RING_BUFFER_CAPACITY;
+        uint32_t next = (pop + 1) % Capacity;
         popPtr.store(next, std::memory_order_release);
         return true;
     }
@@ -54,15 +58,17 @@ struct RingBuffer {
     bool full() const {
         uint32_t push = pushPtr.load(std::memory_order_acquire);
         uint32_t pop = popPtr.load(std::memory_order_acquire);
-        return ((push + 1) % RING_BUFFER_CAPACITY) == pop;
+        return ((push + 1) % Capacity) == pop;
     }
 
     uint32_t size() const {
         uint32_t push = pushPtr.load(std::memory_order_acquire);
         uint32_t pop = popPtr.load(std::memory_order_acquire);
-        return (push + RING_BUFFER_CAPACITY - pop) % RING_BUFFER_CAPACITY;
+        return (push + Capacity - pop) % Capacity;
     }
 };
 
+using RingBuffer = SpscRing<MarketData, RING_BUFFER_CAPACITY>;
+
 static_assert(std::is_standard_layout<RingBuffer>::value,
               "RingBuffer must be standard layout for shared memory");
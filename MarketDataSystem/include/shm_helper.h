@@ -4,70 +4,125 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <stdexcept>
+#include <thread>
 #include "ring_buffer.h"
+#include "tsc_clock.h"
 
 namespace shm {
 
 static constexpr const char* SHM_NAME = "/market_data_shm";
 
-// Create and initialize shared memory (for publisher)
-inline RingBuffer* create_shm() {
-    shm_unlink(SHM_NAME);
+// Layout of the shared memory segment. The name exists from shm_open on,
+// before the publisher has sized or filled it in, so the publisher sets
+// ready (release) last, once its clock calibration is in place, and
+// open_shm waits to see it (acquire) before handing the segment out.
+struct ShmSegment {
+    tsc::Calibration clock;
+    std::atomic<uint32_t> ready;
+    RingBuffer ring;
+};
 
-    int fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
+static_assert(std::is_standard_layout<ShmSegment>::value,
+              "ShmSegment must be standard layout for shared memory");
+
+// Create and initialize shared memory (for publisher), stamped with clock
+inline ShmSegment* create_shm(const char* name, const tsc::Calibration& clock) {
+    shm_unlink(name);
+
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0666);
     if (fd == -1) {
         throw std::runtime_error("Failed to create shared memory: " + std::string(strerror(errno)));
     }
 
-    if (ftruncate(fd, sizeof(RingBuffer)) == -1) {
+    if (ftruncate(fd, sizeof(ShmSegment)) == -1) {
         close(fd);
-        shm_unlink(SHM_NAME);
+        shm_unlink(name);
         throw std::runtime_error("Failed to set shared memory size: " + std::string(strerror(errno)));
     }
 
-    void* addr = mmap(nullptr, sizeof(RingBuffer), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void* addr = mmap(nullptr, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (addr == MAP_FAILED) {
         close(fd);
-        shm_unlink(SHM_NAME);
+        shm_unlink(name);
         throw std::runtime_error("Failed to map shared memory: " + std::string(strerror(errno)));
     }
 
     close(fd);
 
-    // Initialize ring buffer using placement new
-    RingBuffer* ring = new (addr) RingBuffer();
-    return ring;
+    // Initialize the segment using placement new, then publish it
+    ShmSegment* segment = new (addr) ShmSegment();
+    segment->clock = clock;
+    segment->ready.store(1, std::memory_order_release);
+    return segment;
 }
 
-// Open existing shared memory (for consumer)
-inline RingBuffer* open_shm() {
-    int fd = shm_open(SHM_NAME, O_RDWR, 0666);
+// Open existing shared memory (for consumer). Waits up to timeout for a
+// publisher that is still setting the segment up.
+inline ShmSegment* open_shm(const char* name = SHM_NAME,
+                            std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) {
+    int fd = shm_open(name, O_RDWR, 0666);
     if (fd == -1) {
         throw std::runtime_error("Failed to open shared memory: " + std::string(strerror(errno)));
     }
 
-    void* addr = mmap(nullptr, sizeof(RingBuffer), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // Touching pages past the end before ftruncate would fault
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    struct stat st;
+    while (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) < sizeof(ShmSegment)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            close(fd);
+            throw std::runtime_error("Shared memory was never sized by its publisher");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    void* addr = mmap(nullptr, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (addr == MAP_FAILED) {
         close(fd);
         throw std::runtime_error("Failed to map shared memory: " + std::string(strerror(errno)));
     }
 
     close(fd);
-    return static_cast<RingBuffer*>(addr);
+    auto* segment = static_cast<ShmSegment*>(addr);
+    while (segment->ready.load(std::memory_order_acquire) == 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            munmap(addr, sizeof(ShmSegment));
+            throw std::runtime_error("Shared memory was never initialized by its publisher");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return segment;
 }
 
 // Close shared memory mapping
-inline void close_shm(RingBuffer* ring) {
-    if (ring != nullptr) {
-        munmap(ring, sizeof(RingBuffer));
+inline void close_shm(ShmSegment* segment) {
+    if (segment != nullptr) {
+        munmap(segment, sizeof(ShmSegment));
+    }
+}
+
+// Adopt the clock calibration from a publisher's segment, for processes
+// that do not otherwise read it. Falls back to calibrating locally if the
+// segment does not exist; returns true if the publisher's was used.
+inline bool adopt_clock(const char* name = SHM_NAME) {
+    try {
+        ShmSegment* segment = open_shm(name);
+        tsc::use(segment->clock);
+        close_shm(segment);
+        return true;
+    } catch (const std::runtime_error&) {
+        tsc::use(tsc::calibrate());
+        return false;
     }
 }
 
 // Cleanup shared memory (for publisher on exit)
-inline void cleanup_shm() {
-    shm_unlink(SHM_NAME);
+inline void cleanup_shm(const char* name = SHM_NAME) {
+    shm_unlink(name);
 }
 
 } // namespace shm
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TSC_CLOCK_X86 1
+#endif
+
+// Calibrated TSC clock
+//
+// Reading the invariant TSC costs a few nanoseconds, versus a vDSO
+// clock_gettime on every message. At startup the publisher measures the TSC
+// rate against CLOCK_MONOTONIC_RAW, anchors it to CLOCK_REALTIME (timestamps
+// stay epoch nanoseconds) and stores the result in the shm segment. Consumers
+// adopt that calibration, so cycles from every process are converted on the
+// same scale and cross-process latencies do not pick up two independent
+// calibration errors.
+//
+// If the CPU does not report an invariant TSC (CPUID 0x80000007 EDX bit 8),
+// or on non-x86, the calibration is marked invalid and now_ns() reads the
+// system clock instead.
+
+namespace tsc {
+
+// Conversion parameters; plain data so it can live in shared memory
+struct Calibration {
+    uint64_t tsc_base;      // TSC at the anchor
+    uint64_t ns_base;       // CLOCK_REALTIME at the anchor, in ns
+    uint64_t mult;          // ns per cycle, 32.32 fixed point
+    uint32_t valid;         // 0: use the system clock
+    uint32_t reserved;
+};
+
+inline uint64_t rdtsc() {
+#ifdef TSC_CLOCK_X86
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Waits for earlier instructions (e.g. the load that received a message)
+// before reading the counter
+inline uint64_t rdtscp() {
+#ifdef TSC_CLOCK_X86
+    unsigned int aux;
+    return __rdtscp(&aux);
+#else
+    return 0;
+#endif
+}
+
+inline bool invariant_tsc() {
+#ifdef TSC_CLOCK_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+        return false;
+    }
+    __cpuid(0x80000007, eax, ebx, ecx, edx);
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+inline uint64_t clock_ns(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Pair a clock reading with the TSC, keeping the attempt whose bracketing
+// TSC reads are closest together
+inline void paired_read(clockid_t clock, uint64_t& tsc, uint64_t& ns) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 16; i++) {
+        uint64_t before = rdtsc();
+        uint64_t now = clock_ns(clock);
+        uint64_t after = rdtsc();
+        if (after - before < best) {
+            best = after - before;
+            tsc = before + (after - before) / 2;
+            ns = now;
+        }
+    }
+}
+
+// Measure the TSC rate over duration (blocks for that long)
+inline Calibration calibrate(std::chrono::milliseconds duration = std::chrono::milliseconds(50)) {
+    Calibration calibration{};
+    if (!invariant_tsc()) {
+        return calibration;
+    }
+
+    uint64_t tsc_start = 0, raw_start = 0, tsc_end = 0, raw_end = 0;
+    paired_read(CLOCK_MONOTONIC_RAW, tsc_start, raw_start);
+    std::this_thread::sleep_for(duration);
+    paired_read(CLOCK_MONOTONIC_RAW, tsc_end, raw_end);
+    if (tsc_end <= tsc_start) {
+        return calibration;
+    }
+
+    calibration.mult = ((raw_end - raw_start) << 32) / (tsc_end - tsc_start);
+    paired_read(CLOCK_REALTIME, calibration.tsc_base, calibration.ns_base);
+    calibration.valid = 1;
+    return calibration;
+}
+
+inline double ghz(const Calibration& calibration) {
+    return calibration.valid ? 4294967296.0 / static_cast<double>(calibration.mult) : 0.0;
+}
+
+// The calibration this process converts with
+inline Calibration active{};
+
+inline void use(const Calibration& calibration) {
+    active = calibration;
+}
+
+// Current time in epoch nanoseconds
+inline uint64_t now_ns() {
+    if (active.valid) {
+        int64_t cycles = static_cast<int64_t>(rdtscp() - active.tsc_base);
+        __int128 ns = (static_cast<__int128>(cycles) * static_cast<__int128>(active.mult)) >> 32;
+        return active.ns_base + static_cast<uint64_t>(static_cast<int64_t>(ns));
+    }
+    return clock_ns(CLOCK_REALTIME);
+}
+
+} // namespace tsc
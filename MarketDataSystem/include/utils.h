@@ -1,71 +1,314 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <string>
-#include <sstream>
-#include <iomanip>
+#include <ctime>
 #include "market_data.h"
+#include "instruments.h"
+#include "json_scan.h"
+#include "tsc_clock.h"
 
 namespace utils {
 
-// Get current timestamp in nanoseconds
+// Get current timestamp in nanoseconds since the epoch. Uses the TSC once
+// a calibration is active (see tsc_clock.h), the system clock otherwise.
 inline uint64_t get_timestamp_ns() {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto nanos = std::chrono::time_point_cast<std::chrono::nanoseconds>(now);
-    return nanos.time_since_epoch().count();
+    return tsc::now_ns();
 }
 
-// Format timestamp for logging (HH:MM:SS.nanoseconds)
-inline std::string format_timestamp(uint64_t timestamp_ns) {
-    auto seconds = timestamp_ns / 1'000'000'000;
-    auto nanos = timestamp_ns % 1'000'000'000;
+// Upper bound on the length of one JSON message
+static constexpr size_t MAX_JSON_SIZE = 160;
+
+namespace detail {
+
+// Scanning helpers for the fixed-layout JSON below. Each advances p past
+// what it matched and never reads at or beyond end.
+template<size_t N>
+inline bool expect(const char*& p, const char* end, const char (&literal)[N]) {
+    if (static_cast<size_t>(end - p) < N - 1 || std::memcmp(p, literal, N - 1) != 0) {
+        return false;
+    }
+    p += N - 1;
+    return true;
+}
+
+inline bool parse_uint(const char*& p, const char* end, uint64_t& value) {
+    const char* start = p;
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9' && p - start < 20) {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        p++;
+    }
+    return p > start;
+}
+
+// Decimal price as digits[.digits], at most 15 significant digits. Both
+// the mantissa (< 10^15 < 2^53) and the power of ten are then exact
+// doubles, so a single division gives the same correctly rounded double as
+// strtod. Longer numbers are rejected rather than silently losing digits.
+inline bool parse_price(const char*& p, const char* end, double& value) {
+    static constexpr int MAX_DIGITS = 15;
+    static constexpr double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                       1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    bool negative = p < end && *p == '-';
+    if (negative) {
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int decimals = 0;
+    bool seen_point = false;
+    for (; p < end; p++) {
+        if (*p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            decimals += seen_point;
+            if (++digits > MAX_DIGITS) {
+                return false;
+            }
+        } else if (*p == '.' && !seen_point) {
+            seen_point = true;
+        } else {
+            break;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    value = static_cast<double>(mantissa) / POW10[decimals];
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
 
-    auto time = std::chrono::system_clock::from_time_t(seconds);
-    auto time_t_val = std::chrono::system_clock::to_time_t(time);
 
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t_val), "%H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(9) << nanos;
+// Decimal writers for to_json. Digits are emitted two at a time from a
+// pair table, so there is no locale lookup or format-string parsing.
+static constexpr char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
 
-    return ss.str();
+inline char* write_uint(char* out, uint64_t value) {
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    while (value >= 100) {
+        p -= 2;
+        std::memcpy(p, DIGIT_PAIRS + (value % 100) * 2, 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        p -= 2;
+        std::memcpy(p, DIGIT_PAIRS + value * 2, 2);
+    } else {
+        *--p = static_cast<char>('0' + value);
+    }
+    size_t n = digits + sizeof(digits) - p;
+    std::memcpy(out, p, n);
+    return out + n;
+}
+
+// Write value with exactly two decimals: value * 100 (itself rounded to a
+// double) is rounded to the nearest integer, halves away from zero. printf's
+// "%.2f" instead rounds the exact binary value, halves to even, so the two
+// can differ by one cent on values off the 0.01 grid that sit at or within
+// an ulp of a half cent (0.125 gives 0.13 here, 0.12 from printf). Prices
+// on the grid are far from a half cent and always match. Anything too large
+// for the integer path (or not finite) falls back to "%.17g".
+inline char* write_price(char* out, double value) {
+    if (!(value > -1e15 && value < 1e15)) {
+        return out + std::snprintf(out, 32, "%.17g", value);
+    }
+    if (value < 0) {
+        *out++ = '-';
+        value = -value;
+    }
+    uint64_t cents = static_cast<uint64_t>(std::llround(value * 100.0));
+    out = write_uint(out, cents / 100);
+    *out++ = '.';
+    std::memcpy(out, DIGIT_PAIRS + (cents % 100) * 2, 2);
+    return out + 2;
+}
+
+template<size_t N>
+inline char* write_literal(char* out, const char (&literal)[N]) {
+    std::memcpy(out, literal, N - 1);
+    return out + N - 1;
+}
+
+} // namespace detail
+
+// Length of a formatted timestamp (HH:MM:SS.nnnnnnnnn)
+static constexpr size_t TIMESTAMP_SIZE = 18;
+
+// Format timestamp for logging (HH:MM:SS.nanoseconds) into out, which must
+// hold TIMESTAMP_SIZE bytes (no terminator), returning one past the end.
+// The local-time HH:MM:SS prefix is cached per thread and recomputed only
+// when the second changes; the nanoseconds come from the digit-pair table.
+inline char* format_timestamp(uint64_t timestamp_ns, char* out) {
+    thread_local uint64_t cached_second = UINT64_MAX;
+    thread_local char prefix[8];
+
+    uint64_t seconds = timestamp_ns / 1'000'000'000;
+    uint32_t nanos = static_cast<uint32_t>(timestamp_ns % 1'000'000'000);
+
+    if (seconds != cached_second) {
+        time_t time_t_val = static_cast<time_t>(seconds);
+        struct tm local;
+        localtime_r(&time_t_val, &local);
+        std::memcpy(prefix, detail::DIGIT_PAIRS + local.tm_hour * 2, 2);
+        prefix[2] = ':';
+        std::memcpy(prefix + 3, detail::DIGIT_PAIRS + local.tm_min * 2, 2);
+        prefix[5] = ':';
+        std::memcpy(prefix + 6, detail::DIGIT_PAIRS + local.tm_sec * 2, 2);
+        cached_second = seconds;
+    }
+
+    std::memcpy(out, prefix, sizeof(prefix));
+    out[8] = '.';
+    out[9] = static_cast<char>('0' + nanos / 100'000'000);
+    nanos %= 100'000'000;
+    for (char* p = out + 16; p > out + 9; p -= 2) {
+        std::memcpy(p, detail::DIGIT_PAIRS + (nanos % 100) * 2, 2);
+        nanos /= 100;
+    }
+    return out + TIMESTAMP_SIZE;
+}
+
+inline std::string format_timestamp(uint64_t timestamp_ns) {
+    char buffer[TIMESTAMP_SIZE];
+    format_timestamp(timestamp_ns, buffer);
+    return std::string(buffer, TIMESTAMP_SIZE);
+}
+
+// Write MarketData as JSON into buffer (no terminator), returning the length
+inline size_t to_json(const MarketData& data, char* buffer, size_t size) {
+    char line[2 * MAX_JSON_SIZE];
+    char* p = detail::write_literal(line, "{\"instrument\":\"");
+    size_t symbol_len = strnlen(data.instrument, sizeof(data.instrument));
+    std::memcpy(p, data.instrument, symbol_len);
+    p += symbol_len;
+    p = detail::write_literal(p, "\",\"bid\":");
+    p = detail::write_price(p, data.bid);
+    p = detail::write_literal(p, ",\"ask\":");
+    p = detail::write_price(p, data.ask);
+    p = detail::write_literal(p, ",\"timestamp_ns\":");
+    p = detail::write_uint(p, data.timestamp_ns);
+    p = detail::write_literal(p, ",\"seq\":");
+    p = detail::write_uint(p, data.seq_num);
+    *p++ = '}';
+
+    size_t len = std::min(static_cast<size_t>(p - line), size - 1);
+    std::memcpy(buffer, line, len);
+    return len;
 }
 
 // Convert MarketData to JSON string
 inline std::string to_json(const MarketData& data) {
-    char buffer[256];
-    int len = std::snprintf(buffer, sizeof(buffer),
-        "{\"instrument\":\"%s\",\"bid\":%.2f,\"ask\":%.2f,\"timestamp_ns\":%lu}",
-        data.instrument,
-        data.bid,
-        data.ask,
-        data.timestamp_ns);
+    char buffer[MAX_JSON_SIZE];
+    size_t len = to_json(data, buffer, sizeof(buffer));
     return std::string(buffer, len);
 }
 
-// Parse JSON to MarketData
-inline bool from_json(const std::string& json, MarketData& data) {
-    char instrument[16];
-    double bid, ask;
-    unsigned long long timestamp_ns;
+// Parse JSON to MarketData from a character range (no terminator needed,
+// no allocation). Trailing bytes after the closing brace are rejected, as
+// are symbols outside the instrument universe, so a successful parse always
+// leaves a valid instrument_id.
+// A vectorized scan first marks every structural character, so each value
+// ends at the next mark rather than at a per-byte test.
+inline bool from_json(const char* json, size_t len, MarketData& data) {
+    if (len > json_scan::MAX_LINE) {
+        return false;
+    }
+    json_scan::Structurals marks;
+    json_scan::scan(json, len, marks);
+
+    const char* p = json;
+    const char* end = json + len;
+    auto value_end = [&](const char* value) {
+        return std::min(json + marks.next(value - json), end);
+    };
+
+    if (!detail::expect(p, end, "{\"instrument\":\"")) {
+        return false;
+    }
+    const char* symbol = p;
+    const char* quote = value_end(p);
+    if (quote == end || *quote != '"' || quote == symbol ||
+        static_cast<size_t>(quote - symbol) >= sizeof(data.instrument)) {
+        return false;
+    }
+    p = quote;
 
-    int parsed = std::sscanf(json.c_str(),
-        "{\"instrument\":\"%15[^\"]\",\"bid\":%lf,\"ask\":%lf,\"timestamp_ns\":%llu}",
-        instrument,
-        &bid,
-        &ask,
-        &timestamp_ns);
+    double bid, ask;
+    uint64_t timestamp_ns, seq;
+    if (!detail::expect(p, end, "\",\"bid\":") || !detail::parse_price(p, value_end(p), bid) ||
+        !detail::expect(p, end, ",\"ask\":") || !detail::parse_price(p, value_end(p), ask) ||
+        !detail::expect(p, end, ",\"timestamp_ns\":") || !detail::parse_uint(p, value_end(p), timestamp_ns) ||
+        !detail::expect(p, end, ",\"seq\":") || !detail::parse_uint(p, value_end(p), seq) ||
+        !detail::expect(p, end, "}") || p != end) {
+        return false;
+    }
 
-    if (parsed != 4) {
+    char instrument[sizeof(data.instrument)] = {};
+    std::memcpy(instrument, symbol, quote - symbol);
+    uint32_t instrument_id = instruments::find(instrument);
+    if (instrument_id == instruments::INVALID_ID) {
         return false;
     }
 
-    std::memset(data.instrument, 0, sizeof(data.instrument));
-    std::strncpy(data.instrument, instrument, sizeof(data.instrument) - 1);
+    std::memcpy(data.instrument, instrument, sizeof(instrument));
     data.bid = bid;
     data.ask = ask;
     data.timestamp_ns = timestamp_ns;
+    data.seq_num = seq;
+    data.instrument_id = instrument_id;
 
     return true;
 }
 
+inline bool from_json(const std::string& json, MarketData& data) {
+    return from_json(json.data(), json.size(), data);
+}
+
+// Snapshot header sent to a newly connected client. It is followed by
+// `count` messages holding the latest state of each instrument, after which
+// live updates resume at seq + 1.
+inline size_t snapshot_header_json(uint64_t seq, uint32_t count, char* buffer, size_t size) {
+    int len = std::snprintf(buffer, size,
+        "{\"snapshot_seq\":%" PRIu64 ",\"count\":%" PRIu32 "}", seq, count);
+    return len < 0 ? 0 : std::min(static_cast<size_t>(len), size - 1);
+}
+
+inline std::string snapshot_header_json(uint64_t seq, uint32_t count) {
+    char buffer[64];
+    size_t len = snapshot_header_json(seq, count, buffer, sizeof(buffer));
+    return std::string(buffer, len);
+}
+
+// Parse a snapshot header (returns false for any other message)
+inline bool parse_snapshot_header(const char* json, size_t len, uint64_t& seq, uint32_t& count) {
+    const char* p = json;
+    const char* end = json + len;
+    uint64_t s, c;
+    if (!detail::expect(p, end, "{\"snapshot_seq\":") || !detail::parse_uint(p, end, s) ||
+        !detail::expect(p, end, ",\"count\":") || !detail::parse_uint(p, end, c) ||
+        !detail::expect(p, end, "}") || p != end || c > UINT32_MAX) {
+        return false;
+    }
+    seq = s;
+    count = static_cast<uint32_t>(c);
+    return true;
+}
+
+inline bool parse_snapshot_header(const std::string& json, uint64_t& seq, uint32_t& count) {
+    return parse_snapshot_header(json.data(), json.size(), seq, count);
+}
+
 } // namespace utils
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <linux/errqueue.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+// MSG_ZEROCOPY helpers (Linux >= 4.14)
+//
+// A send with MSG_ZEROCOPY pins the user pages instead of copying them, so
+// the buffer must stay untouched until the kernel reports completion on the
+// socket's error queue. Every successful zerocopy send is numbered (0, 1, 2,
+// ... per socket) and completions arrive as inclusive [lo, hi] ranges of
+// those numbers. On loopback the kernel usually falls back to copying and
+// says so with SO_EE_CODE_ZEROCOPY_COPIED.
+
+namespace zerocopy {
+
+// Opt the socket in; returns false if the kernel does not support it
+inline bool enable(int fd) {
+    int one = 1;
+    return setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+}
+
+// Read all pending completions without blocking.
+// on_complete(lo, hi, copied) is called for each notification.
+template<typename OnComplete>
+inline int drain_completions(int fd, OnComplete&& on_complete) {
+    int notifications = 0;
+    while (true) {
+        char control[128];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+            break;  // EAGAIN: queue drained
+        }
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            bool ip_error = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+            if (!ip_error) {
+                continue;
+            }
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+            if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) {
+                continue;
+            }
+            on_complete(err.ee_info, err.ee_data, (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+            notifications++;
+        }
+    }
+    return notifications;
+}
+
+// Wrap-safe "id <= hi" for the 32-bit notification counter
+inline bool completed(uint32_t id, uint32_t hi) {
+    return static_cast<int32_t>(hi - id) >= 0;
+}
+
+} // namespace zerocopy
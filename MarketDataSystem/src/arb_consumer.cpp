@@ -0,0 +1,462 @@
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <fmt/core.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../include/async_log.h"
+#include "../include/feed_parser.h"
+#include "../include/latency_histogram.h"
+#include "../include/market_data.h"
+#include "../include/ring_buffer.h"
+#include "../include/shm_helper.h"
+#include "../include/utils.h"
+
+using boost::asio::ip::tcp;
+
+volatile sig_atomic_t running = 1;
+
+void signal_handler(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        running = 0;
+    }
+}
+
+// Pin thread to specific CPU core to reduce context switches
+inline bool set_cpu_affinity(int cpu_id) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu_id, &cpuset);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
+}
+
+// One redundant copy of the sequenced feed. poll() never blocks.
+class FeedLine {
+public:
+    virtual ~FeedLine() = default;
+
+    // Returns true and fills data if a live update is available
+    virtual bool poll(MarketData& data) = 0;
+    virtual bool alive() const = 0;
+
+    // Publisher clock calibration, if the line carries one
+    virtual const tsc::Calibration* clock() const { return nullptr; }
+};
+
+// Shared memory line - pops from the publisher's ring buffer
+class ShmLine : public FeedLine {
+public:
+    explicit ShmLine(const std::string& name)
+        : name_(name), segment_(shm::open_shm(name_.c_str())) {}
+
+    ~ShmLine() override { shm::close_shm(segment_); }
+
+    bool poll(MarketData& data) override { return segment_->ring.pop(data); }
+    bool alive() const override { return true; }
+    const tsc::Calibration* clock() const override { return &segment_->clock; }
+
+private:
+    std::string name_;
+    shm::ShmSegment* segment_;
+};
+
+// TCP line - non-blocking socket carrying newline-delimited JSON.
+// Snapshot entries carry old sequence numbers and are skipped; arbitration
+// only looks at live updates.
+class TcpLine : public FeedLine {
+public:
+    TcpLine(boost::asio::io_context& io_context, const std::string& host, const std::string& port)
+        : socket_(io_context) {
+        tcp::resolver resolver(io_context);
+        boost::asio::connect(socket_, resolver.resolve(host, port));
+        socket_.set_option(tcp::no_delay(true));
+        socket_.non_blocking(true);
+    }
+
+    bool poll(MarketData& data) override {
+        while (alive_) {
+            feed::FrameType type;
+            while ((type = parser_.next(buffer_)) != feed::FrameType::NEED_MORE) {
+                if (type == feed::FrameType::SNAPSHOT) {
+                    snapshot_remaining_ = parser_.snapshot_count();
+                } else if (type == feed::FrameType::UPDATE) {
+                    if (snapshot_remaining_ > 0) {
+                        snapshot_remaining_--;
+                        continue;
+                    }
+                    data = parser_.data();
+                    return true;
+                }
+            }
+
+            char* tail = buffer_.write_ptr();
+            if (buffer_.write_space() == 0) {
+                fmt::print("Error: Line too long on TCP feed\n");
+                alive_ = false;
+                break;
+            }
+
+            boost::system::error_code ec;
+            size_t n = socket_.read_some(boost::asio::buffer(tail, buffer_.write_space()), ec);
+            if (ec == boost::asio::error::would_block) {
+                return false;
+            }
+            if (ec) {
+                fmt::print("TCP line closed: {}\n", ec.message());
+                alive_ = false;
+                break;
+            }
+            buffer_.commit(n);
+        }
+        return false;
+    }
+
+    bool alive() const override { return alive_; }
+
+private:
+    tcp::socket socket_;
+    RecvBuffer buffer_;
+    feed::FeedParser parser_;
+    uint32_t snapshot_remaining_ = 0;
+    bool alive_ = true;
+};
+
+// Open a line from "shm:/name" or "tcp:host:port"
+std::unique_ptr<FeedLine> open_line(boost::asio::io_context& io_context, const std::string& spec) {
+    if (spec.rfind("shm:", 0) == 0) {
+        return std::make_unique<ShmLine>(spec.substr(4));
+    }
+    if (spec.rfind("tcp:", 0) == 0) {
+        std::string address = spec.substr(4);
+        size_t colon = address.rfind(':');
+        if (colon != std::string::npos) {
+            return std::make_unique<TcpLine>(io_context, address.substr(0, colon), address.substr(colon + 1));
+        }
+    }
+    throw std::runtime_error("Invalid feed spec (expected shm:/name or tcp:host:port): " + spec);
+}
+
+// A/B arbiter
+// Releases every sequence number exactly once, in order, from whichever line
+// delivered it first. A gap on one line is held for up to gap_timeout_ns so
+// the other line can fill it; it is declared lost once both lines have moved
+// past it or the timeout expires. The slower copy of each sequence number is
+// used for lead/lag statistics.
+class Arbiter {
+public:
+    static constexpr int LINES = 2;
+    static constexpr uint64_t WINDOW = 4096;
+
+    struct LineStats {
+        uint64_t received = 0;
+        uint64_t first = 0;        // Delivered a sequence number first
+        uint64_t late = 0;         // Delivered a copy the other line already had
+        uint64_t stale = 0;        // Too old to arbitrate (outside the window)
+        uint64_t lead_sum_ns = 0;  // Summed over its wins the other line also delivered
+        uint64_t lag_sum_ns = 0;   // Summed over its late copies
+        uint64_t max_lag_ns = 0;
+    };
+
+    explicit Arbiter(uint64_t gap_timeout_ns) : gap_timeout_ns_(gap_timeout_ns) {}
+
+    template<typename Emit>
+    void on_update(int line, const MarketData& data, uint64_t now_ns, Emit&& emit) {
+        LineStats& stats = stats_[line];
+        stats.received++;
+        uint64_t seq = data.seq_num;
+        last_seq_[line] = std::max(last_seq_[line], seq);
+        if (next_ == 0) {
+            next_ = seq;
+        }
+
+        Slot& slot = window_[seq % WINDOW];
+        if (slot.seq == seq) {
+            if (slot.first_line != line && !slot.both_seen) {
+                uint64_t lag = now_ns - slot.first_arrival_ns;
+                slot.both_seen = true;
+                stats.late++;
+                stats.lag_sum_ns += lag;
+                stats.max_lag_ns = std::max(stats.max_lag_ns, lag);
+                stats_[slot.first_line].lead_sum_ns += lag;
+            }
+            return;
+        }
+        if (seq < next_) {
+            stats.stale++;
+            return;
+        }
+        if (seq >= next_ + WINDOW) {
+            skip_to(seq - WINDOW + 1, emit);
+        }
+
+        slot.seq = seq;
+        slot.first_arrival_ns = now_ns;
+        slot.first_line = static_cast<uint8_t>(line);
+        slot.both_seen = false;
+        slot.pending = true;
+        slot.data = data;
+        pending_count_++;
+        stats.first++;
+
+        release(now_ns, emit);
+
+        // Both lines are sequenced, so once each has passed a hole it is lost
+        while (pending_count_ > 0 && std::min(last_seq_[0], last_seq_[1]) > next_) {
+            lost_++;
+            next_++;
+            release(now_ns, emit);
+        }
+    }
+
+    // Declare the oldest hole lost once it has been open for the gap timeout
+    template<typename Emit>
+    void on_idle(uint64_t now_ns, Emit&& emit) {
+        while (pending_count_ > 0 && now_ns - gap_since_ns_ >= gap_timeout_ns_) {
+            lost_++;
+            next_++;
+            release(now_ns, emit);
+        }
+    }
+
+    const LineStats& stats(int line) const { return stats_[line]; }
+    uint64_t emitted() const { return emitted_; }
+    uint64_t lost() const { return lost_; }
+
+private:
+    struct Slot {
+        uint64_t seq = 0;
+        uint64_t first_arrival_ns = 0;
+        uint8_t first_line = 0;
+        bool both_seen = false;
+        bool pending = false;
+        MarketData data;
+    };
+
+    template<typename Emit>
+    void release(uint64_t now_ns, Emit&& emit) {
+        Slot* slot = &window_[next_ % WINDOW];
+        if (!(slot->seq == next_ && slot->pending) && pending_count_ > 0 && gap_since_ns_ == 0) {
+            gap_since_ns_ = now_ns;
+        }
+        while (slot->seq == next_ && slot->pending) {
+            slot->pending = false;
+            pending_count_--;
+            emitted_++;
+            emit(slot->first_line, slot->data);
+            next_++;
+            slot = &window_[next_ % WINDOW];
+            gap_since_ns_ = pending_count_ > 0 ? now_ns : 0;
+        }
+    }
+
+    // Give up on everything below seq, releasing what is buffered in order
+    template<typename Emit>
+    void skip_to(uint64_t seq, Emit&& emit) {
+        while (next_ < seq) {
+            Slot& slot = window_[next_ % WINDOW];
+            if (slot.seq == next_ && slot.pending) {
+                slot.pending = false;
+                pending_count_--;
+                emitted_++;
+                emit(slot.first_line, slot.data);
+            } else {
+                lost_++;
+            }
+            next_++;
+        }
+        gap_since_ns_ = 0;  // Any hole it covered is gone; release() re-arms
+    }
+
+    std::array<Slot, WINDOW> window_;
+    std::array<LineStats, LINES> stats_;
+    std::array<uint64_t, LINES> last_seq_{};
+    uint64_t next_ = 0;
+    uint64_t pending_count_ = 0;
+    uint64_t gap_since_ns_ = 0;
+    uint64_t gap_timeout_ns_;
+    uint64_t emitted_ = 0;
+    uint64_t lost_ = 0;
+};
+
+int main(int argc, char* argv[]) {
+    std::string line_specs[Arbiter::LINES] = {"tcp:127.0.0.1:8080", "tcp:127.0.0.1:8081"};
+    bool busy_wait = false;
+    int cpu_core = 4;  // Default: separate from others
+    int log_cpu = 5;   // Housekeeping core for the log thread
+    uint64_t gap_timeout_us = 1000;
+    bool quiet = false;              // No per-message lines
+    const char* hist_out = nullptr;  // Dump the run's histogram here on exit
+    uint64_t count = 0;              // Exit after this many updates (0: never)
+    const char* shm_name = shm::SHM_NAME;  // Clock source when no line is shm
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--a") == 0 && i + 1 < argc) {
+            line_specs[0] = argv[++i];
+        } else if (strcmp(argv[i], "--b") == 0 && i + 1 < argc) {
+            line_specs[1] = argv[++i];
+        } else if (strcmp(argv[i], "--busy-wait") == 0 || strcmp(argv[i], "-b") == 0) {
+            busy_wait = true;
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu_core = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--gap-timeout-us") == 0 && i + 1 < argc) {
+            gap_timeout_us = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--log-cpu") == 0 && i + 1 < argc) {
+            log_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--hist-out") == 0 && i + 1 < argc) {
+            hist_out = argv[++i];
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        }
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    try {
+        fmt::print("Starting A/B Arbitration Consumer...\n");
+
+        if (set_cpu_affinity(cpu_core)) {
+            fmt::print("CPU affinity set: Pinned to CPU {}\n", cpu_core);
+        } else {
+            fmt::print("Warning: Could not set CPU affinity\n");
+        }
+
+        if (alog::AsyncLogger::instance().start(log_cpu)) {
+            fmt::print("Log thread pinned to CPU {}\n", log_cpu);
+        } else {
+            fmt::print("Warning: Could not pin log thread to CPU {}\n", log_cpu);
+        }
+
+        boost::asio::io_context io_context;
+        std::unique_ptr<FeedLine> lines[Arbiter::LINES];
+        for (int i = 0; i < Arbiter::LINES; i++) {
+            lines[i] = open_line(io_context, line_specs[i]);
+            fmt::print("Line {}: {}\n", static_cast<char>('A' + i), line_specs[i]);
+        }
+
+        // Stamp with the first shm line's clock, else the publisher's segment
+        // named by --shm-name, else calibrate locally
+        const tsc::Calibration* clock = lines[0]->clock() ? lines[0]->clock() : lines[1]->clock();
+        if (clock != nullptr) {
+            tsc::use(*clock);
+        } else {
+            shm::adopt_clock(shm_name);
+        }
+        if (tsc::active.valid) {
+            fmt::print("Clock: TSC at {:.3f} GHz\n", tsc::ghz(tsc::active));
+        } else {
+            fmt::print("Clock: system clock (TSC disabled or not invariant)\n");
+        }
+
+        Arbiter arbiter(gap_timeout_us * 1'000);
+        fmt::print("Consumer ready. Arbitrating with {} us gap timeout...\n", gap_timeout_us);
+
+        // Latency is publish to release, so it includes any time an update
+        // waited in the window for a hole to fill
+        LatencyHistogram histogram;
+        uint64_t first_release_ts = 0;
+        uint64_t last_release_ts = 0;
+        // Independent check on the released stream: every hole should be one
+        // the arbiter counted as lost, and nothing should come out twice
+        uint64_t last_released_seq = 0;
+        uint64_t seq_gaps = 0;
+        uint64_t seq_duplicates = 0;
+        auto emit = [&](uint8_t line, const MarketData& data) {
+            uint64_t receive_ts = utils::get_timestamp_ns();
+            if (last_released_seq != 0 && data.seq_num <= last_released_seq) {
+                seq_duplicates++;
+            } else {
+                if (last_released_seq != 0) {
+                    seq_gaps += data.seq_num - last_released_seq - 1;
+                }
+                last_released_seq = data.seq_num;
+            }
+            histogram.record(receive_ts - data.timestamp_ns);
+            if (first_release_ts == 0) {
+                first_release_ts = receive_ts;
+            }
+            last_release_ts = receive_ts;
+            if (histogram.count() == count) {
+                running = 0;
+            }
+            if (quiet) {
+                return;
+            }
+            alog::log(FMT_STRING("[{}] [{}] {} BID={:.2f} ASK={:.2f} (seq {}, latency: {} ns)\n"),
+                alog::Timestamp{receive_ts},
+                static_cast<char>('A' + line),
+                data.instrument,
+                data.bid,
+                data.ask,
+                data.seq_num,
+                receive_ts - data.timestamp_ns);
+        };
+
+        MarketData data;
+        while (running && (lines[0]->alive() || lines[1]->alive())) {
+            bool idle = true;
+            // One update per line per pass so arrival stamps stay fair
+            for (int i = 0; i < Arbiter::LINES; i++) {
+                if (lines[i]->poll(data)) {
+                    idle = false;
+                    arbiter.on_update(i, data, utils::get_timestamp_ns(), emit);
+                }
+            }
+            arbiter.on_idle(utils::get_timestamp_ns(), emit);
+
+            if (idle && !busy_wait) {
+                std::this_thread::sleep_for(std::chrono::microseconds(1));
+            }
+        }
+
+        alog::AsyncLogger::instance().stop();
+        fmt::print("\nShutting down. Emitted {} updates, {} lost on both lines (log records dropped: {})\n",
+            arbiter.emitted(), arbiter.lost(), alog::AsyncLogger::instance().dropped());
+        fmt::print("Sequence check: {} missing, {} duplicate or out of order\n", seq_gaps, seq_duplicates);
+        for (int i = 0; i < Arbiter::LINES; i++) {
+            const Arbiter::LineStats& stats = arbiter.stats(i);
+            const Arbiter::LineStats& other = arbiter.stats(1 - i);
+            fmt::print("Line {}: received {}, first {} ({:.1f}%), late {}, stale {}, "
+                       "avg lead {} ns, avg lag {} ns, max lag {} ns\n",
+                static_cast<char>('A' + i),
+                stats.received,
+                stats.first,
+                arbiter.emitted() > 0 ? 100.0 * stats.first / arbiter.emitted() : 0.0,
+                stats.late,
+                stats.stale,
+                other.late > 0 ? stats.lead_sum_ns / other.late : 0,
+                stats.late > 0 ? stats.lag_sum_ns / stats.late : 0,
+                stats.max_lag_ns);
+        }
+        if (histogram.count() > 0) {
+            fmt::print("Latency: {} (avg {} ns)\n", histogram.percentiles(), histogram.mean());
+            fmt::print("Throughput: {:.0f} msg/s\n", last_release_ts > first_release_ts
+                ? static_cast<double>(histogram.count() - 1) * 1e9 / static_cast<double>(last_release_ts - first_release_ts) : 0.0);
+        }
+        if (hist_out != nullptr) {
+            if (histogram.dump(hist_out)) {
+                fmt::print("Latency histogram written to {}\n", hist_out);
+            } else {
+                fmt::print("Warning: Could not write histogram to {}\n", hist_out);
+            }
+        }
+
+    } catch (std::exception& e) {
+        fmt::print("Error: {}\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
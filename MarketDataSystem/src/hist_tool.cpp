@@ -0,0 +1,48 @@
+#include <cstring>
+#include <vector>
+#include <fmt/core.h>
+#include "../include/latency_histogram.h"
+
+// Merge latency histograms dumped by the consumers (--hist-out) and print
+// percentiles for each input and for the combined distribution
+
+int main(int argc, char* argv[]) {
+    const char* output = nullptr;
+    std::vector<const char*> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (inputs.empty()) {
+        fmt::print("Usage: {} [-o merged.hist] run1.hist [run2.hist ...]\n", argv[0]);
+        return 1;
+    }
+
+    LatencyHistogram merged;
+    LatencyHistogram histogram;
+    for (const char* path : inputs) {
+        if (!histogram.load(path)) {
+            fmt::print("Error: Could not read histogram {}\n", path);
+            return 1;
+        }
+        fmt::print("{}: {}\n", path, histogram.percentiles());
+        merged.merge(histogram);
+    }
+
+    if (inputs.size() > 1) {
+        fmt::print("merged: {}\n", merged.percentiles());
+    }
+    if (output != nullptr) {
+        if (!merged.dump(output)) {
+            fmt::print("Error: Could not write histogram {}\n", output);
+            return 1;
+        }
+        fmt::print("Wrote {}\n", output);
+    }
+    return 0;
+}
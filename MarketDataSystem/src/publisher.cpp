@@ -1,19 +1,38 @@
 #include <iostream>
 #include <memory>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <random>
 #include <thread>
 #include <chrono>
+#include <csignal>
+#include <cstring>
 #include <boost/asio.hpp>
 #include <fmt/core.h>
 #include <pthread.h>
 #include <sched.h>
 #include "../include/market_data.h"
+#include "../include/instruments.h"
+#include "../include/compact_codec.h"
+#include "../include/frame_pool.h"
+#include "../include/zerocopy.h"
 #include "../include/ring_buffer.h"
 #include "../include/shm_helper.h"
 #include "../include/utils.h"
 
 using boost::asio::ip::tcp;
 
+volatile sig_atomic_t running = 1;
+
+void signal_handler(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        running = 0;
+    }
+}
+
 // Pin thread to specific CPU core to reduce context switches
 inline bool set_cpu_affinity(int cpu_id) {
     cpu_set_t cpuset;
@@ -22,80 +41,604 @@ inline bool set_cpu_affinity(int cpu_id) {
     return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
 }
 
+// Frames queued for a non-conflating session before it is dropped as too slow
+static constexpr size_t MAX_QUEUED_FRAMES = 65536;
+
+// Queued frames handed to the kernel in one gathered write
+static constexpr size_t MAX_WRITE_BATCH = 64;
+
+// Session slots; each instrument keeps a bitmap over these
+static constexpr uint32_t MAX_SESSIONS = 256;
+static constexpr uint32_t SESSION_WORDS = MAX_SESSIONS / 64;
+using SessionBitmap = std::array<uint64_t, SESSION_WORDS>;
+
+class Session;
+using CommandHandler = std::function<void(const std::shared_ptr<Session>&, const std::string&)>;
+using CloseHandler = std::function<void(uint32_t slot)>;
+
 // TCP Session - handles each client connection
+// All session state is touched only from the io_context thread.
 class Session : public std::enable_shared_from_this<Session> {
 public:
-    Session(tcp::socket socket) : socket_(std::move(socket)) {}
+    Session(tcp::socket socket, uint32_t slot, bool conflate, FramePool& frame_pool,
+            size_t zerocopy_threshold, CommandHandler on_command, CloseHandler on_close)
+        : socket_(std::move(socket)),
+          slot_(slot),
+          frame_pool_(frame_pool),
+          conflate_(conflate),
+          zerocopy_threshold_(zerocopy_threshold),
+          zerocopy_timer_(socket_.get_executor()),
+          on_command_(std::move(on_command)),
+          on_close_(std::move(on_close)) {}
 
     void start() {
         socket_.set_option(tcp::no_delay(true));  // Disable Nagle's algorithm
         socket_.set_option(boost::asio::socket_base::send_buffer_size(65536));
         socket_.set_option(boost::asio::socket_base::keep_alive(true));
+        if (zerocopy_threshold_ > 0 && !zerocopy::enable(socket_.native_handle())) {
+            fmt::print("Warning: SO_ZEROCOPY not supported, using copy path\n");
+            zerocopy_threshold_ = 0;
+        }
+        do_read();
+    }
+
+    // Queue a frame; the session holds a reference until the write that
+    // carries it completes. Writes are serialized so frames reach the client
+    // in the order they were queued.
+    void send_frame(FrameRef frame) {
+        if (!alive_) {
+            return;
+        }
+        if (write_queue_.size() >= MAX_QUEUED_FRAMES) {
+            fmt::print("Dropping slow client ({} frames queued)\n", write_queue_.size());
+            close();
+            return;
+        }
+        // Conflated updates are older than anything queued from now on
+        flush_dirty();
+        write_queue_.push_back(std::move(frame));
+        if (!writing_) {
+            do_write();
+        }
+    }
+
+    // Send a live update. In conflation mode an update that arrives while a
+    // write is still in flight only overwrites the instrument's slot in the
+    // dirty-set; the newest values are flushed once the socket drains.
+    // json_frame is serialized once and shared by all JSON sessions; compact
+    // sessions encode against their own per-connection state.
+    void send_update(const MarketData& data, const FrameRef& json_frame) {
+        if (conflate_ && writing_) {
+            uint64_t bit = uint64_t{1} << data.instrument_id;
+            if (dirty_ & bit) {
+                conflated_count_++;
+            }
+            dirty_ |= bit;
+            pending_[data.instrument_id] = data;
+            return;
+        }
+        if (compact_) {
+            FrameRef frame = frame_pool_.acquire(codec::MAX_FRAME_SIZE);
+            frame->size = static_cast<uint32_t>(
+                encoder_.encode(data, reinterpret_cast<uint8_t*>(frame->data())));
+            send_frame(std::move(frame));
+        } else {
+            send_frame(json_frame);
+        }
+    }
+
+    void subscribe(uint64_t mask) { subscriptions_ |= mask; }
+
+    void unsubscribe(uint64_t mask) {
+        subscriptions_ &= ~mask;
+        dirty_ &= ~mask;
+    }
+
+    void set_conflate(bool conflate) { conflate_ = conflate; }
+
+    // Switching to compact restarts the codec, so each instrument's next
+    // update goes out as a keyframe
+    void set_compact(bool compact) {
+        compact_ = compact;
+        encoder_.reset();
+    }
+
+    uint64_t subscriptions() const { return subscriptions_; }
+    uint32_t slot() const { return slot_; }
+    bool alive() const { return alive_; }
+    uint64_t conflated_count() const { return conflated_count_; }
+
+private:
+    void do_read() {
+        auto self = shared_from_this();
+        boost::asio::async_read_until(socket_, read_buffer_, '\n',
+            [this, self](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    close();
+                    return;
+                }
+                std::istream is(&read_buffer_);
+                std::string line;
+                std::getline(is, line);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (!line.empty()) {
+                    on_command_(self, line);
+                }
+                if (alive_) {
+                    do_read();
+                }
+            });
+    }
+
+    bool use_zerocopy(const FrameRef& frame) const {
+        return zerocopy_threshold_ > 0 && frame->size >= zerocopy_threshold_;
     }
 
-    void send_data(const std::string& message) {
+    // Gather up to MAX_WRITE_BATCH queued frames into one write. A frame
+    // above the zerocopy threshold goes out on its own.
+    void do_write() {
+        writing_ = true;
+        if (use_zerocopy(write_queue_.front())) {
+            zerocopy_offset_ = 0;
+            do_zerocopy_write();
+            return;
+        }
+        write_buffers_.clear();
+        for (size_t i = 0; i < write_queue_.size() && i < MAX_WRITE_BATCH; i++) {
+            if (use_zerocopy(write_queue_[i])) {
+                break;
+            }
+            write_buffers_.emplace_back(write_queue_[i]->data(), write_queue_[i]->size);
+        }
         auto self = shared_from_this();
-        boost::asio::async_write(socket_,
-            boost::asio::buffer(message + "\n"),
+        boost::asio::async_write(socket_, write_buffers_,
             [this, self](boost::system::error_code ec, std::size_t) {
                 if (ec) {
                     fmt::print("Error sending data: {}\n", ec.message());
+                    close();
+                    return;
                 }
+                on_write_complete(write_buffers_.size());
             });
     }
 
-private:
+    void on_write_complete(size_t frames) {
+        write_queue_.erase(write_queue_.begin(), write_queue_.begin() + frames);
+        if (write_queue_.empty()) {
+            flush_dirty();
+        }
+        if (write_queue_.empty()) {
+            writing_ = false;
+        } else {
+            do_write();
+        }
+    }
+
+    // Send the front frame with MSG_ZEROCOPY. Each successful send takes the
+    // next notification ID and parks a reference to the frame until the
+    // kernel reports that ID complete, so the pool cannot reuse pinned pages.
+    void do_zerocopy_write() {
+        auto self = shared_from_this();
+        socket_.async_wait(tcp::socket::wait_write, [this, self](boost::system::error_code ec) {
+            if (ec || !alive_) {
+                close();
+                return;
+            }
+            const FrameRef& frame = write_queue_.front();
+            ssize_t sent = ::send(socket_.native_handle(),
+                frame->data() + zerocopy_offset_, frame->size - zerocopy_offset_,
+                MSG_ZEROCOPY | MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    do_zerocopy_write();
+                } else if (errno == ENOBUFS) {
+                    // Out of optmem for pinned pages: copy the rest instead
+                    boost::asio::async_write(socket_,
+                        boost::asio::buffer(frame->data() + zerocopy_offset_, frame->size - zerocopy_offset_),
+                        [this, self](boost::system::error_code write_ec, std::size_t) {
+                            if (write_ec) {
+                                close();
+                                return;
+                            }
+                            on_write_complete(1);
+                        });
+                } else {
+                    fmt::print("Error sending data: {}\n", std::strerror(errno));
+                    close();
+                }
+                return;
+            }
+
+            zerocopy_in_flight_.push_back({zerocopy_next_id_++, frame});
+            zerocopy_sends_++;
+            zerocopy_offset_ += sent;
+            reap_zerocopy();
+            if (zerocopy_offset_ < frame->size) {
+                do_zerocopy_write();
+            } else {
+                on_write_complete(1);
+            }
+        });
+    }
+
+    // Release frames whose notification IDs the kernel has completed. The
+    // error queue raises EPOLLERR; the timer covers a readiness edge that
+    // fires while no wait is armed.
+    void reap_zerocopy() {
+        zerocopy::drain_completions(socket_.native_handle(), [this](uint32_t, uint32_t hi, bool copied) {
+            if (copied) {
+                zerocopy_copied_++;
+            }
+            while (!zerocopy_in_flight_.empty() && zerocopy::completed(zerocopy_in_flight_.front().id, hi)) {
+                zerocopy_in_flight_.pop_front();
+            }
+        });
+        if (zerocopy_in_flight_.empty() || !alive_) {
+            return;
+        }
+
+        auto self = shared_from_this();
+        if (!zerocopy_wait_armed_) {
+            zerocopy_wait_armed_ = true;
+            socket_.async_wait(tcp::socket::wait_error, [this, self](boost::system::error_code ec) {
+                zerocopy_wait_armed_ = false;
+                if (!ec) {
+                    reap_zerocopy();
+                }
+            });
+        }
+        if (!zerocopy_timer_armed_) {
+            zerocopy_timer_armed_ = true;
+            zerocopy_timer_.expires_after(std::chrono::milliseconds(1));
+            zerocopy_timer_.async_wait([this, self](boost::system::error_code ec) {
+                zerocopy_timer_armed_ = false;
+                if (!ec) {
+                    reap_zerocopy();
+                }
+            });
+        }
+    }
+
+    // Serialize the latest value of every dirty instrument into one frame,
+    // in sequence order so the client still sees increasing seq numbers.
+    void flush_dirty() {
+        if (dirty_ == 0) {
+            return;
+        }
+        std::array<const MarketData*, instruments::COUNT> updates;
+        size_t count = 0;
+        for (uint64_t mask = dirty_; mask != 0; mask &= mask - 1) {
+            updates[count++] = &pending_[__builtin_ctzll(mask)];
+        }
+        dirty_ = 0;
+        std::sort(updates.begin(), updates.begin() + count,
+            [](const MarketData* a, const MarketData* b) { return a->seq_num < b->seq_num; });
+
+        size_t per_update = compact_ ? codec::MAX_FRAME_SIZE : utils::MAX_JSON_SIZE;
+        FrameRef frame = frame_pool_.acquire(count * per_update);
+        char* out = frame->data();
+        for (size_t i = 0; i < count; i++) {
+            if (compact_) {
+                out += encoder_.encode(*updates[i], reinterpret_cast<uint8_t*>(out));
+            } else {
+                out += utils::to_json(*updates[i], out, per_update);
+                *out++ = '\n';
+            }
+        }
+        frame->size = static_cast<uint32_t>(out - frame->data());
+        write_queue_.push_back(std::move(frame));
+    }
+
+    // The queue is left alone: a cancelled write may still reference its front.
+    // The server is told on a fresh handler so it never unregisters a session
+    // in the middle of routing to it.
+    void close() {
+        if (!alive_) {
+            return;
+        }
+        alive_ = false;
+        dirty_ = 0;
+        if (zerocopy_sends_ > 0) {
+            fmt::print("Session zerocopy sends: {} ({} completions reported copied)\n",
+                zerocopy_sends_, zerocopy_copied_);
+        }
+        boost::system::error_code ignored;
+        zerocopy_timer_.cancel();
+        socket_.close(ignored);
+        boost::asio::post(socket_.get_executor(),
+            [on_close = on_close_, slot = slot_]() { on_close(slot); });
+    }
+
     tcp::socket socket_;
+    uint32_t slot_;
+    FramePool& frame_pool_;
+    std::deque<FrameRef> write_queue_;
+    std::vector<boost::asio::const_buffer> write_buffers_;
+    boost::asio::streambuf read_buffer_;
+    bool writing_ = false;
+    bool alive_ = true;
+    uint64_t subscriptions_ = 0;
+
+    // Conflation state: bounded by the instrument universe
+    bool conflate_;
+    uint64_t dirty_ = 0;
+    std::array<MarketData, instruments::COUNT> pending_;
+    uint64_t conflated_count_ = 0;
+
+    bool compact_ = false;
+    codec::Encoder encoder_;
+
+    // MSG_ZEROCOPY state: frames stay referenced until their send completes
+    struct ZeroCopySend {
+        uint32_t id;
+        FrameRef frame;
+    };
+    size_t zerocopy_threshold_;
+    size_t zerocopy_offset_ = 0;
+    uint32_t zerocopy_next_id_ = 0;
+    std::deque<ZeroCopySend> zerocopy_in_flight_;
+    boost::asio::steady_timer zerocopy_timer_;
+    bool zerocopy_wait_armed_ = false;
+    bool zerocopy_timer_armed_ = false;
+    uint64_t zerocopy_sends_ = 0;
+    uint64_t zerocopy_copied_ = 0;
+
+    CommandHandler on_command_;
+    CloseHandler on_close_;
 };
 
 // TCP Server - accepts client connections
+// Keeps the latest quote per instrument so a late joiner can be bootstrapped
+// with a snapshot. Updates and accepts both run on the io_context thread, so
+// the snapshot sequence number and the first live delta never overlap.
+// Updates reach the io thread through an SPSC ring; the publisher thread
+// posts a drain only when none is already queued, so a burst costs one
+// post and one wake-up rather than one per update.
+//
+// Clients control their feed with newline-terminated commands:
+//   SUB <SYM>[,<SYM>...] | SUB *     subscribe (replies with a snapshot)
+//   UNSUB <SYM>[,<SYM>...] | UNSUB * unsubscribe
+//   CONFLATE ON | CONFLATE OFF       per-session conflation
+//   ENCODING COMPACT | ENCODING JSON live update encoding (snapshots stay JSON)
+// New sessions start subscribed to every instrument.
 class Server {
 public:
-    Server(boost::asio::io_context& io_context, short port)
-        : acceptor_(io_context, tcp::endpoint(tcp::v4(), port)) {
+    Server(boost::asio::io_context& io_context, short port, bool conflate, FramePool& frame_pool,
+           size_t zerocopy_threshold)
+        : io_context_(io_context),
+          acceptor_(io_context, tcp::endpoint(tcp::v4(), port)),
+          conflate_(conflate),
+          frame_pool_(frame_pool),
+          zerocopy_threshold_(zerocopy_threshold) {
         accept();
     }
 
-    void broadcast(const std::string& message) {
-        for (auto& session : sessions_) {
-            session->send_data(message);
+    // Called from the publisher thread; hands the update to the io thread.
+    // Waits if the io thread has fallen a whole ring behind: the feed is
+    // sequenced, so updates are never dropped here.
+    void publish(const MarketData& data) {
+        while (!pending_->push(data)) {
+            std::this_thread::yield();
+        }
+        if (!drain_posted_.exchange(true)) {
+            boost::asio::post(io_context_, [this]() { drain(); });
         }
     }
 
 private:
+    // Cleared before popping, so an update pushed after the last pop finds
+    // the flag clear and posts another drain
+    void drain() {
+        drain_posted_.exchange(false);
+        MarketData data;
+        while (pending_->pop(data)) {
+            on_market_data(data);
+        }
+    }
+
+    void on_market_data(const MarketData& data) {
+        if (data.instrument_id >= instruments::COUNT) {
+            return;
+        }
+        latest_[data.instrument_id] = data;
+        has_latest_[data.instrument_id] = true;
+        last_seq_ = data.seq_num;
+        route(data);
+    }
+
+    // Visit only the sessions whose bit is set for this instrument
+    void route(const MarketData& data) {
+        const SessionBitmap& bitmap = subscribers_[data.instrument_id];
+        FrameRef frame;
+        for (uint32_t word = 0; word < SESSION_WORDS; word++) {
+            for (uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+                if (!frame) {
+                    frame = frame_pool_.acquire(utils::MAX_JSON_SIZE + 1);
+                    size_t len = utils::to_json(data, frame->data(), utils::MAX_JSON_SIZE);
+                    frame->data()[len] = '\n';
+                    frame->size = static_cast<uint32_t>(len + 1);
+                }
+                uint32_t slot = word * 64 + __builtin_ctzll(bits);
+                sessions_[slot]->send_update(data, frame);
+            }
+        }
+    }
+
+    // Snapshot header followed by the latest quote for each instrument in mask
+    FrameRef build_snapshot(uint64_t mask) {
+        uint32_t count = 0;
+        for (uint32_t id = 0; id < instruments::COUNT; id++) {
+            if ((mask & (uint64_t{1} << id)) && has_latest_[id]) {
+                count++;
+            }
+        }
+
+        FrameRef frame = frame_pool_.acquire((count + 1) * utils::MAX_JSON_SIZE);
+        char* out = frame->data();
+        out += utils::snapshot_header_json(last_seq_, count, out, utils::MAX_JSON_SIZE);
+        *out++ = '\n';
+        for (uint32_t id = 0; id < instruments::COUNT; id++) {
+            if ((mask & (uint64_t{1} << id)) && has_latest_[id]) {
+                out += utils::to_json(latest_[id], out, utils::MAX_JSON_SIZE);
+                *out++ = '\n';
+            }
+        }
+        frame->size = static_cast<uint32_t>(out - frame->data());
+        return frame;
+    }
+
+    void subscribe(Session& session, uint64_t mask) {
+        session.subscribe(mask);
+        for (uint32_t id = 0; id < instruments::COUNT; id++) {
+            if (mask & (uint64_t{1} << id)) {
+                subscribers_[id][session.slot() / 64] |= uint64_t{1} << (session.slot() % 64);
+            }
+        }
+        session.send_frame(build_snapshot(mask));
+    }
+
+    void unsubscribe(Session& session, uint64_t mask) {
+        session.unsubscribe(mask);
+        for (uint32_t id = 0; id < instruments::COUNT; id++) {
+            if (mask & (uint64_t{1} << id)) {
+                subscribers_[id][session.slot() / 64] &= ~(uint64_t{1} << (session.slot() % 64));
+            }
+        }
+    }
+
+    void on_command(const std::shared_ptr<Session>& session, const std::string& line) {
+        char verb[16];
+        char arg[256];
+        if (std::sscanf(line.c_str(), "%15s %255s", verb, arg) != 2) {
+            fmt::print("Ignoring malformed command: {}\n", line);
+            return;
+        }
+        if (strcmp(verb, "CONFLATE") == 0) {
+            if (strcmp(arg, "ON") == 0 || strcmp(arg, "OFF") == 0) {
+                session->set_conflate(strcmp(arg, "ON") == 0);
+            } else {
+                fmt::print("Ignoring CONFLATE with unknown mode: {}\n", line);
+            }
+            return;
+        }
+        if (strcmp(verb, "ENCODING") == 0) {
+            if (strcmp(arg, "COMPACT") == 0 || strcmp(arg, "JSON") == 0) {
+                session->set_compact(strcmp(arg, "COMPACT") == 0);
+            } else {
+                fmt::print("Ignoring ENCODING with unknown mode: {}\n", line);
+            }
+            return;
+        }
+        uint64_t mask;
+        if (!instruments::parse_symbol_list(arg, mask)) {
+            fmt::print("Ignoring command with unknown instrument: {}\n", line);
+            return;
+        }
+        if (strcmp(verb, "SUB") == 0) {
+            subscribe(*session, mask);
+        } else if (strcmp(verb, "UNSUB") == 0) {
+            unsubscribe(*session, mask);
+        } else {
+            fmt::print("Ignoring unknown command: {}\n", line);
+        }
+    }
+
+    void on_close(uint32_t slot) {
+        if (!sessions_[slot]) {
+            return;
+        }
+        unsubscribe(*sessions_[slot], instruments::ALL_MASK);
+        sessions_[slot].reset();
+        free_slots_.push_back(slot);
+        session_count_--;
+        fmt::print("Client disconnected. Total clients: {}\n", session_count_);
+    }
+
     void accept() {
         acceptor_.async_accept(
             [this](boost::system::error_code ec, tcp::socket socket) {
                 if (!ec) {
-                    auto session = std::make_shared<Session>(std::move(socket));
-                    sessions_.push_back(session);
-                    session->start();
-                    fmt::print("Client connected. Total clients: {}\n", sessions_.size());
+                    if (free_slots_.empty() && next_slot_ == MAX_SESSIONS) {
+                        fmt::print("Rejecting client: {} sessions already connected\n", MAX_SESSIONS);
+                    } else {
+                        uint32_t slot;
+                        if (!free_slots_.empty()) {
+                            slot = free_slots_.back();
+                            free_slots_.pop_back();
+                        } else {
+                            slot = next_slot_++;
+                        }
+                        auto session = std::make_shared<Session>(std::move(socket), slot, conflate_, frame_pool_, zerocopy_threshold_,
+                            [this](const std::shared_ptr<Session>& s, const std::string& line) { on_command(s, line); },
+                            [this](uint32_t closed_slot) { on_close(closed_slot); });
+                        sessions_[slot] = session;
+                        session_count_++;
+                        session->start();
+                        subscribe(*session, instruments::ALL_MASK);
+                        fmt::print("Client connected at seq {}. Total clients: {}\n",
+                            last_seq_, session_count_);
+                    }
                 }
                 accept();
             });
     }
 
+    boost::asio::io_context& io_context_;
     tcp::acceptor acceptor_;
-    std::vector<std::shared_ptr<Session>> sessions_;
+    bool conflate_;
+    FramePool& frame_pool_;
+    size_t zerocopy_threshold_;
+
+    std::array<std::shared_ptr<Session>, MAX_SESSIONS> sessions_;
+    std::vector<uint32_t> free_slots_;
+    uint32_t next_slot_ = 0;
+    uint32_t session_count_ = 0;
+    std::array<SessionBitmap, instruments::COUNT> subscribers_{};
+
+    std::array<MarketData, instruments::COUNT> latest_{};
+    std::array<bool, instruments::COUNT> has_latest_{};
+    uint64_t last_seq_ = 0;
+
+    // Publisher thread -> io thread
+    static constexpr uint32_t PENDING_CAPACITY = 16384;
+    std::unique_ptr<SpscRing<MarketData, PENDING_CAPACITY>> pending_ =
+        std::make_unique<SpscRing<MarketData, PENDING_CAPACITY>>();
+    std::atomic<bool> drain_posted_{false};
 };
 
 // Market Data Generator - generates simulated market data
+// Cycles through the instrument universe and stamps a global sequence number.
+// Each instrument's mid price is a random walk on the tick grid, so
+// consecutive quotes differ by a few ticks as on a real feed.
 class MarketDataGenerator {
 public:
-    MarketDataGenerator()
-        : rng_(std::random_device{}()),
-          price_dist_(2800.0, 2900.0),
-          spread_dist_(0.25, 1.0) {}
+    // A fixed seed makes two publishers produce the same stream (A/B lines)
+    explicit MarketDataGenerator(uint32_t seed)
+        : rng_(seed != 0 ? seed : std::random_device{}()),
+          step_dist_(-3, 3),
+          spread_dist_(1, 10) {
+        for (uint32_t id = 0; id < instruments::COUNT; id++) {
+            mid_ticks_[id] = std::llround(instruments::UNIVERSE[id].base_price / instruments::TICK_SIZE);
+        }
+    }
 
     MarketData generate() {
-        double mid_price = price_dist_(rng_);
-        double spread = spread_dist_(rng_);
+        uint32_t id = next_instrument_;
+        next_instrument_ = (next_instrument_ + 1) % instruments::COUNT;
+
+        mid_ticks_[id] += step_dist_(rng_);
+        int64_t spread = spread_dist_(rng_);
+        int64_t bid_ticks = mid_ticks_[id] - spread / 2;
+        int64_t ask_ticks = bid_ticks + spread;
 
         MarketData data;
-        std::strncpy(data.instrument, "RELIANCE", sizeof(data.instrument) - 1);
-        data.bid = mid_price - spread / 2.0;
-        data.ask = mid_price + spread / 2.0;
+        std::strncpy(data.instrument, instruments::UNIVERSE[id].symbol, sizeof(data.instrument) - 1);
+        data.instrument_id = id;
+        data.bid = bid_ticks * instruments::TICK_SIZE;
+        data.ask = ask_ticks * instruments::TICK_SIZE;
+        data.seq_num = ++seq_;
         data.timestamp_ns = utils::get_timestamp_ns();
 
         return data;
@@ -103,68 +646,186 @@ public:
 
 private:
     std::mt19937 rng_;
-    std::uniform_real_distribution<double> price_dist_;
-    std::uniform_real_distribution<double> spread_dist_;
+    std::uniform_int_distribution<int64_t> step_dist_;
+    std::uniform_int_distribution<int64_t> spread_dist_;
+    std::array<int64_t, instruments::COUNT> mid_ticks_;
+    uint32_t next_instrument_ = 0;
+    uint64_t seq_ = 0;
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    bool conflate = false;
+    uint64_t rate = 10'000;  // Updates per second
+    short tcp_port = 8080;
+    const char* shm_name = shm::SHM_NAME;
+    uint32_t seed = 0;       // 0: random
+    uint64_t start_at = 0;   // Epoch seconds of the first update (0: now)
+    uint64_t delay_us = 0;   // Injected line delay
+    double drop_rate = 0.0;  // Injected line loss
+    size_t zerocopy_threshold = 0;  // 0: MSG_ZEROCOPY disabled
+    bool use_tsc = true;
+    uint64_t count = 0;      // Updates to publish (0: until interrupted)
+    int cpu_core = 0;        // Generator / shm producer
+    int io_cpu = 1;          // Asio thread (TCP sends)
+    bool quiet = false;      // No progress lines
+    bool spin_pace = false;  // Spin the last 50 us before each send instead of sleeping
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--conflate") == 0 || strcmp(argv[i], "-c") == 0) {
+            conflate = true;
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            tcp_port = static_cast<short>(std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--start-at") == 0 && i + 1 < argc) {
+            start_at = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--delay-us") == 0 && i + 1 < argc) {
+            delay_us = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--drop-rate") == 0 && i + 1 < argc) {
+            drop_rate = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--no-tsc") == 0) {
+            use_tsc = false;
+        } else if (strcmp(argv[i], "--zerocopy-threshold") == 0 && i + 1 < argc) {
+            zerocopy_threshold = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu_core = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--io-cpu") == 0 && i + 1 < argc) {
+            io_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--spin-pace") == 0) {
+            spin_pace = true;
+        }
+    }
+    if (rate == 0) {
+        fmt::print("Error: --rate must be positive\n");
+        return 1;
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
     try {
         fmt::print("Starting Market Data Publisher...\n");
 
-        // Pin main thread to CPU 0
-        if (set_cpu_affinity(0)) {
-            fmt::print("CPU affinity set: Main thread pinned to CPU 0\n");
+        if (set_cpu_affinity(cpu_core)) {
+            fmt::print("CPU affinity set: Main thread pinned to CPU {}\n", cpu_core);
         } else {
             fmt::print("Warning: Could not set CPU affinity\n");
         }
 
+        // Calibrate the TSC clock; consumers pick it up from the segment
+        if (use_tsc) {
+            tsc::use(tsc::calibrate());
+        }
+        if (tsc::active.valid) {
+            fmt::print("Clock: TSC at {:.3f} GHz\n", tsc::ghz(tsc::active));
+        } else {
+            fmt::print("Clock: system clock (TSC disabled or not invariant)\n");
+        }
+
         // Create shared memory
         fmt::print("Creating shared memory...\n");
-        RingBuffer* ring_buffer = shm::create_shm();
+        shm::ShmSegment* segment = shm::create_shm(shm_name, tsc::active);
+        RingBuffer* ring_buffer = &segment->ring;
 
         // Start TCP server
-        const short TCP_PORT = 8080;
-        fmt::print("Starting TCP server on port {}...\n", TCP_PORT);
+        fmt::print("Starting TCP server on port {}...\n", tcp_port);
 
+        // Outlives io_context so frames held by pending handlers can be released.
+        // Warmed for single-update frames in both encodings.
+        FramePool frame_pool({utils::MAX_JSON_SIZE + 1, codec::MAX_FRAME_SIZE});
         boost::asio::io_context io_context;
-        Server server(io_context, TCP_PORT);
+        Server server(io_context, tcp_port, conflate, frame_pool, zerocopy_threshold);
+        if (zerocopy_threshold > 0) {
+            fmt::print("Frames of {}+ bytes are sent with MSG_ZEROCOPY\n", zerocopy_threshold);
+        }
+        fmt::print("Publishing {} updates/sec\n", rate);
+        if (conflate) {
+            fmt::print("TCP sessions conflate per instrument when the socket backs up\n");
+        }
 
-        // Run io_context in separate thread (pinned to CPU 1)
-        std::thread io_thread([&io_context]() {
-            set_cpu_affinity(1);
+        // Run io_context in separate thread
+        std::thread io_thread([&io_context, io_cpu]() {
+            set_cpu_affinity(io_cpu);
             io_context.run();
         });
 
-        MarketDataGenerator generator;
+        MarketDataGenerator generator(seed);
+
+        // Line impairment for A/B arbitration tests: dropped updates still
+        // consume a sequence number
+        std::mt19937 drop_rng(std::random_device{}());
+        std::bernoulli_distribution drop_dist(drop_rate);
+        if (delay_us > 0 || drop_rate > 0.0) {
+            fmt::print("Injecting {} us delay and {:.2f}% loss\n", delay_us, drop_rate * 100.0);
+        }
+
+        // Pace against absolute deadlines so oversleeping is caught up on the
+        // next message and the average rate holds. --spin-pace spins the last
+        // 50 us for tighter spacing at the cost of a busy core.
+        // Publishers sharing --seed, --rate and --start-at emit each seq at
+        // the same instant, offset only by --delay-us.
+        const uint64_t interval_ns = 1'000'000'000 / rate;
+        uint64_t next_send_ns = (start_at != 0 ? start_at * 1'000'000'000 : utils::get_timestamp_ns())
+            + delay_us * 1'000;
+        uint64_t now_ns = utils::get_timestamp_ns();
+        if (next_send_ns > now_ns) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(next_send_ns - now_ns));
+        }
         fmt::print("Publisher ready. Generating market data...\n");
 
         uint64_t message_count = 0;
-        while (true) {
+        while (running && (count == 0 || message_count < count)) {
             MarketData data = generator.generate();
-            std::string json = utils::to_json(data);
+            bool dropped = drop_rate > 0.0 && drop_dist(drop_rng);
 
             // Send via TCP
-            server.broadcast(json);
+            if (!dropped) {
+                server.publish(data);
+            }
 
             // Push to shared memory
-            if (!ring_buffer->push(data)) {
+            if (!dropped && !ring_buffer->push(data)) {
                 fmt::print("Warning: Shared memory ring buffer is full!\n");
             }
 
             message_count++;
-            if (message_count % 100 == 0) {
+            if (!quiet && message_count % 100 == 0) {
                 fmt::print("Published {} messages. Latest: {} BID={:.2f} ASK={:.2f}\n",
                     message_count, data.instrument, data.bid, data.ask);
             }
 
-            // 10,000 updates/sec
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            next_send_ns += interval_ns;
+            uint64_t spin_ns = spin_pace ? 50'000 : 0;
+            uint64_t now = utils::get_timestamp_ns();
+            if (next_send_ns > now + spin_ns) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(next_send_ns - now - spin_ns));
+            }
+            while (spin_pace && utils::get_timestamp_ns() < next_send_ns) {
+                // Spin for the remainder
+            }
+        }
+
+        fmt::print("Published {} messages\n", message_count);
+        if (running && count != 0) {
+            // Keep serving until interrupted so TCP consumers can drain
+            fmt::print("Count reached. Press Ctrl+C to exit\n");
+            while (running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
         }
 
         io_context.stop();
         io_thread.join();
-        shm::close_shm(ring_buffer);
-        shm::cleanup_shm();
+        shm::close_shm(segment);
+        shm::cleanup_shm(shm_name);
 
     } catch (std::exception& e) {
         fmt::print("Error: {}\n", e.what());
@@ -0,0 +1,102 @@
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <fmt/core.h>
+#include "../include/capture_file.h"
+#include "../include/market_data.h"
+#include "../include/ring_buffer.h"
+#include "../include/shm_helper.h"
+#include "../include/utils.h"
+
+// Record the shm feed into a capture file (see capture_file.h) for replay.
+// The ring is single-consumer: the recorder takes the place of shm_consumer
+// on the segment it attaches to.
+
+volatile sig_atomic_t running = 1;
+
+void signal_handler(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        running = 0;
+    }
+}
+
+// Pin thread to specific CPU core to reduce context switches
+inline bool set_cpu_affinity(int cpu_id) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu_id, &cpuset);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool busy_wait = false;
+    int cpu_core = 2;  // Same core shm_consumer would use
+    const char* shm_name = shm::SHM_NAME;
+    const char* output = "capture.bin";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--busy-wait") == 0 || strcmp(argv[i], "-b") == 0) {
+            busy_wait = true;
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu_core = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        }
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    try {
+        fmt::print("Starting Recorder...\n");
+
+        if (set_cpu_affinity(cpu_core)) {
+            fmt::print("CPU affinity set: Pinned to CPU {}\n", cpu_core);
+        } else {
+            fmt::print("Warning: Could not set CPU affinity\n");
+        }
+
+        shm::ShmSegment* segment = shm::open_shm(shm_name);
+        RingBuffer* ring_buffer = &segment->ring;
+        tsc::use(segment->clock);
+
+        capture::CaptureWriter writer(output);
+        fmt::print("Recording {} to {}\n", shm_name, output);
+
+        MarketData data;
+        uint64_t gaps = 0;
+        uint64_t expected_seq = 0;
+        bool first = true;
+        while (running) {
+            if (ring_buffer->pop(data)) {
+                writer.append(data, utils::get_timestamp_ns());
+                if (!first && data.seq_num != expected_seq) {
+                    gaps++;
+                }
+                expected_seq = data.seq_num + 1;
+                first = false;
+            } else if (!busy_wait) {
+                std::this_thread::sleep_for(std::chrono::microseconds(1));
+            }
+        }
+
+        uint64_t count = writer.count();
+        uint64_t bytes = writer.bytes();
+        if (!writer.close()) {
+            fmt::print("Warning: Could not trim {} to its records\n", output);
+        }
+        fmt::print("\nRecorded {} messages ({} bytes, {} sequence gaps) to {}\n", count, bytes, gaps, output);
+        shm::close_shm(segment);
+
+    } catch (std::exception& e) {
+        fmt::print("Error: {}\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <fmt/core.h>
+#include "../include/capture_file.h"
+#include "../include/latency_histogram.h"
+#include "../include/market_data.h"
+#include "../include/ring_buffer.h"
+#include "../include/shm_helper.h"
+#include "../include/utils.h"
+
+// Push a capture (see recorder) into a fresh shm segment, either with the
+// original inter-message gaps or as fast as the consumer drains it. Every
+// update is restamped when pushed, so consumers measure the replay path;
+// seq_num and prices are left as recorded.
+
+volatile sig_atomic_t running = 1;
+
+void signal_handler(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        running = 0;
+    }
+}
+
+// Pin thread to specific CPU core to reduce context switches
+inline bool set_cpu_affinity(int cpu_id) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu_id, &cpuset);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool max_speed = false;
+    int cpu_core = 1;  // Same core the publisher uses
+    const char* shm_name = "/market_data_replay";
+    const char* input = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-speed") == 0) {
+            max_speed = true;
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu_core = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else {
+            input = argv[i];
+        }
+    }
+
+    if (input == nullptr) {
+        fmt::print("Usage: {} [--max-speed] [--shm-name NAME] [--cpu N] capture.bin\n", argv[0]);
+        return 1;
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    try {
+        fmt::print("Starting Replayer...\n");
+
+        if (set_cpu_affinity(cpu_core)) {
+            fmt::print("CPU affinity set: Pinned to CPU {}\n", cpu_core);
+        } else {
+            fmt::print("Warning: Could not set CPU affinity\n");
+        }
+
+        capture::CaptureReader capture(input);
+        if (capture.count() == 0) {
+            fmt::print("{} holds no messages\n", input);
+            return 0;
+        }
+        fmt::print("Loaded {} messages from {}\n", capture.count(), input);
+
+        tsc::use(tsc::calibrate());
+        shm::ShmSegment* segment = shm::create_shm(shm_name, tsc::active);
+        RingBuffer* ring_buffer = &segment->ring;
+
+        fmt::print("Replaying into {} ({}). Start a consumer with --shm-name {}\n",
+            shm_name, max_speed ? "max speed" : "original pacing", shm_name);
+
+        // The first update is pushed once the consumer is there to pop it
+        // (the ring drains), so pacing does not start against a full ring
+        MarketData data = capture[0].data;
+        data.timestamp_ns = utils::get_timestamp_ns();
+        ring_buffer->push(data);
+        while (running && !ring_buffer->empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        uint64_t i = 1;
+        uint64_t start_ns = utils::get_timestamp_ns();
+        uint64_t first_publish_ns = capture[0].data.timestamp_ns;
+        uint64_t full_waits = 0;    // Pushes that found the ring full
+        LatencyHistogram lateness;  // How far behind schedule each push went out
+
+        for (; running && i < capture.count(); i++) {
+            data = capture[i].data;
+            uint64_t now = utils::get_timestamp_ns();
+            if (!max_speed) {
+                uint64_t due = start_ns + (data.timestamp_ns - first_publish_ns);
+                while (now < due && running) {
+                    if (due - now > 100'000) {
+                        std::this_thread::sleep_for(std::chrono::nanoseconds(due - now - 50'000));
+                    }
+                    now = utils::get_timestamp_ns();
+                }
+                lateness.record(now - due);
+            }
+            data.timestamp_ns = now;
+            // Unlike the publisher, never drop: replays must be deterministic
+            if (!ring_buffer->push(data)) {
+                full_waits++;
+                while (!ring_buffer->push(data) && running) {
+                }
+            }
+        }
+
+        uint64_t elapsed_ns = utils::get_timestamp_ns() - start_ns;
+        double seconds = static_cast<double>(elapsed_ns) / 1e9;
+        fmt::print("\nReplayed {} of {} messages in {:.3f} s ({:.0f} msg/s, ring full {} times)\n",
+            i, capture.count(), seconds, seconds > 0 ? static_cast<double>(i - 1) / seconds : 0.0, full_waits);
+        if (!max_speed) {
+            fmt::print("Pacing lateness: {}\n", lateness.percentiles());
+        }
+
+        shm::close_shm(segment);
+        shm::cleanup_shm(shm_name);
+
+    } catch (std::exception& e) {
+        fmt::print("Error: {}\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
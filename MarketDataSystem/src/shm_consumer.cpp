@@ -1,21 +1,31 @@
 #include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <chrono>
 #include <csignal>
 #include <cstring>
+#include <memory>
 #include <pthread.h>
 #include <sched.h>
 #include <fmt/core.h>
+#include "../include/async_log.h"
+#include "../include/compact_codec.h"
+#include "../include/instruments.h"
+#include "../include/latency_histogram.h"
 #include "../include/market_data.h"
 #include "../include/ring_buffer.h"
 #include "../include/shm_helper.h"
 #include "../include/utils.h"
 
-volatile sig_atomic_t running = 1;
+// Cleared by the signal handler or the handler stage, polled by every stage
+// thread in threaded mode; lock-free, so it is safe to store from a handler
+std::atomic<bool> running{true};
+static_assert(std::atomic<bool>::is_always_lock_free, "running must be lock-free for the signal handler");
 
 void signal_handler(int signal) {
     if (signal == SIGINT || signal == SIGTERM) {
-        running = 0;
+        running.store(false, std::memory_order_relaxed);
     }
 }
 
@@ -27,15 +37,154 @@ inline bool set_cpu_affinity(int cpu_id) {
     return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
 }
 
+// One update as it moves through the pipeline, stamped at every stage
+// boundary (publish -> read -> decode -> handle)
+struct StagedQuote {
+    MarketData data;
+    uint64_t read_ts;       // Popped from the shm ring
+    uint64_t decode_ts;     // Normalized
+    int64_t bid_ticks;
+    int64_t ask_ticks;
+};
+
+static constexpr uint32_t STAGE_QUEUE_CAPACITY = 4096;
+using StageQueue = SpscRing<StagedQuote, STAGE_QUEUE_CAPACITY>;
+
+// Stage 1: pop from the shm ring
+inline bool read_stage(RingBuffer& ring, StagedQuote& quote) {
+    if (!ring.pop(quote.data)) {
+        return false;
+    }
+    quote.read_ts = utils::get_timestamp_ns();
+    return true;
+}
+
+// Stage 2: resolve the instrument and convert prices to integer ticks
+inline void decode_stage(StagedQuote& quote) {
+    if (quote.data.instrument_id >= instruments::COUNT) {
+        quote.data.instrument_id = instruments::find(quote.data.instrument);
+    }
+    quote.bid_ticks = codec::to_ticks(quote.data.bid);
+    quote.ask_ticks = codec::to_ticks(quote.data.ask);
+    quote.decode_ts = utils::get_timestamp_ns();
+}
+
+// Stage 3: latency accounting, periodic reports and the per-message line
+class HandlerStage {
+public:
+    HandlerStage(bool quiet, uint64_t report_interval_s, uint64_t limit)
+        : quiet_(quiet),
+          limit_(limit),
+          report_interval_ns_(report_interval_s * 1'000'000'000),
+          next_report_ns_(report_interval_ns_ > 0
+              ? utils::get_timestamp_ns() + report_interval_ns_ : UINT64_MAX) {}
+
+    void on_quote(const StagedQuote& quote) {
+        uint64_t handle_ts = utils::get_timestamp_ns();
+        uint64_t latency_ns = quote.read_ts - quote.data.timestamp_ns;
+        interval_.record(latency_ns);
+        read_to_decode_.record(quote.decode_ts - quote.read_ts);
+        decode_to_handle_.record(handle_ts - quote.decode_ts);
+        end_to_end_.record(handle_ts - quote.data.timestamp_ns);
+
+        if (!quiet_) {
+            alog::log(FMT_STRING("[{}] {} BID={:.2f} ASK={:.2f} (latency: {} ns)\n"),
+                alog::Timestamp{quote.read_ts},
+                quote.data.instrument,
+                quote.data.bid,
+                quote.data.ask,
+                latency_ns);
+        }
+
+        if (handle_ts >= next_report_ns_) {
+            alog::log(FMT_STRING("Latency: {}\n"), interval_.percentiles());
+            transport_.merge(interval_);
+            interval_.reset();
+            next_report_ns_ = handle_ts + report_interval_ns_;
+        }
+        if (message_count_++ == 0) {
+            first_read_ts_ = quote.read_ts;
+        }
+        last_read_ts_ = quote.read_ts;
+        if (message_count_ == limit_) {
+            running.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void finish() {
+        transport_.merge(interval_);
+        interval_.reset();
+    }
+
+    uint64_t message_count() const { return message_count_; }
+    // Receive rate between the first and last update
+    double throughput() const {
+        return last_read_ts_ > first_read_ts_
+            ? static_cast<double>(message_count_ - 1) * 1e9 / static_cast<double>(last_read_ts_ - first_read_ts_) : 0.0;
+    }
+    const LatencyHistogram& transport() const { return transport_; }
+    const LatencyHistogram& read_to_decode() const { return read_to_decode_; }
+    const LatencyHistogram& decode_to_handle() const { return decode_to_handle_; }
+    const LatencyHistogram& end_to_end() const { return end_to_end_; }
+
+private:
+    bool quiet_;
+    uint64_t limit_;                     // Stop after this many updates (0: never)
+    uint64_t report_interval_ns_;
+    uint64_t next_report_ns_;
+    uint64_t message_count_ = 0;
+    uint64_t first_read_ts_ = 0;
+    uint64_t last_read_ts_ = 0;
+    LatencyHistogram transport_;         // publish -> read, whole run
+    LatencyHistogram interval_;          // publish -> read, since last report
+    LatencyHistogram read_to_decode_;
+    LatencyHistogram decode_to_handle_;
+    LatencyHistogram end_to_end_;        // publish -> handle
+};
+
+inline void idle(bool busy_wait) {
+    if (!busy_wait) {
+        std::this_thread::sleep_for(std::chrono::microseconds(1));
+    }
+    // Busy-wait mode: spin without sleeping for lowest latency
+}
+
 int main(int argc, char* argv[]) {
     bool busy_wait = false;
     int cpu_core = 2;  // Default: separate from publisher
+    int log_cpu = 5;   // Housekeeping core for the log thread
+    const char* shm_name = shm::SHM_NAME;
+    bool quiet = false;              // No per-message lines
+    uint64_t report_interval_s = 5;  // Percentile report period; 0: only at exit
+    const char* hist_out = nullptr;  // Dump the run's histogram here on exit
+    bool threaded = false;           // One pinned thread per stage
+    int decoder_cpu = 6;
+    int handler_cpu = 7;
+    uint64_t count = 0;              // Exit after this many updates (0: never)
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--busy-wait") == 0 || strcmp(argv[i], "-b") == 0) {
             busy_wait = true;
         } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
             cpu_core = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--report-interval") == 0 && i + 1 < argc) {
+            report_interval_s = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--hist-out") == 0 && i + 1 < argc) {
+            hist_out = argv[++i];
+        } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            threaded = strcmp(argv[++i], "threaded") == 0;
+        } else if (strcmp(argv[i], "--decoder-cpu") == 0 && i + 1 < argc) {
+            decoder_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--handler-cpu") == 0 && i + 1 < argc) {
+            handler_cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--log-cpu") == 0 && i + 1 < argc) {
+            log_cpu = std::atoi(argv[++i]);
         }
     }
 
@@ -51,6 +200,12 @@ int main(int argc, char* argv[]) {
             fmt::print("Warning: Could not set CPU affinity\n");
         }
 
+        if (alog::AsyncLogger::instance().start(log_cpu)) {
+            fmt::print("Log thread pinned to CPU {}\n", log_cpu);
+        } else {
+            fmt::print("Warning: Could not pin log thread to CPU {}\n", log_cpu);
+        }
+
         if (busy_wait) {
             fmt::print("Mode: BUSY-WAIT (ultra-low latency, high CPU usage)\n");
         } else {
@@ -58,36 +213,103 @@ int main(int argc, char* argv[]) {
         }
 
         fmt::print("Opening shared memory...\n");
-        RingBuffer* ring_buffer = shm::open_shm();
+        shm::ShmSegment* segment = shm::open_shm(shm_name);
+        RingBuffer* ring_buffer = &segment->ring;
+        tsc::use(segment->clock);
+        if (tsc::active.valid) {
+            fmt::print("Clock: TSC at {:.3f} GHz\n", tsc::ghz(tsc::active));
+        } else {
+            fmt::print("Clock: system clock (TSC disabled or not invariant)\n");
+        }
 
+        if (threaded) {
+            fmt::print("Pipeline: threaded (reader CPU {}, decoder CPU {}, handler CPU {})\n",
+                cpu_core, decoder_cpu, handler_cpu);
+        } else {
+            fmt::print("Pipeline: fused (all stages on CPU {})\n", cpu_core);
+        }
         fmt::print("Consumer ready. Waiting for market data from shared memory...\n");
 
-        uint64_t message_count = 0;
-        MarketData data;
+        HandlerStage handler(quiet, report_interval_s, count);
 
-        while (running) {
-            if (ring_buffer->pop(data)) {
-                uint64_t receive_ts = utils::get_timestamp_ns();
-                uint64_t latency_ns = receive_ts - data.timestamp_ns;
+        if (!threaded) {
+            StagedQuote quote;
+            while (running.load(std::memory_order_relaxed)) {
+                if (read_stage(*ring_buffer, quote)) {
+                    decode_stage(quote);
+                    handler.on_quote(quote);
+                } else {
+                    idle(busy_wait);
+                }
+            }
+        } else {
+            // Reader (this thread) -> decoder -> handler over in-process SPSC
+            // queues; a full queue stalls the stage before it
+            auto to_decoder = std::make_unique<StageQueue>();
+            auto to_handler = std::make_unique<StageQueue>();
 
-                fmt::print("[{}] {} BID={:.2f} ASK={:.2f} (latency: {} ns)\n",
-                    utils::format_timestamp(receive_ts),
-                    data.instrument,
-                    data.bid,
-                    data.ask,
-                    latency_ns);
+            std::thread decoder([&] {
+                if (!set_cpu_affinity(decoder_cpu)) {
+                    fmt::print("Warning: Could not pin decoder to CPU {}\n", decoder_cpu);
+                }
+                StagedQuote quote;
+                while (running.load(std::memory_order_relaxed)) {
+                    if (to_decoder->pop(quote)) {
+                        decode_stage(quote);
+                        while (!to_handler->push(quote) && running.load(std::memory_order_relaxed)) {
+                        }
+                    } else {
+                        idle(busy_wait);
+                    }
+                }
+            });
+            std::thread handler_thread([&] {
+                if (!set_cpu_affinity(handler_cpu)) {
+                    fmt::print("Warning: Could not pin handler to CPU {}\n", handler_cpu);
+                }
+                StagedQuote quote;
+                while (running.load(std::memory_order_relaxed)) {
+                    if (to_handler->pop(quote)) {
+                        handler.on_quote(quote);
+                    } else {
+                        idle(busy_wait);
+                    }
+                }
+            });
 
-                message_count++;
-            } else {
-                if (!busy_wait) {
-                    std::this_thread::sleep_for(std::chrono::microseconds(1));
+            StagedQuote quote;
+            while (running.load(std::memory_order_relaxed)) {
+                if (read_stage(*ring_buffer, quote)) {
+                    while (!to_decoder->push(quote) && running.load(std::memory_order_relaxed)) {
+                    }
+                } else {
+                    idle(busy_wait);
                 }
-                // Busy-wait mode: spin without sleeping for lowest latency
             }
+            decoder.join();
+            handler_thread.join();
         }
+        handler.finish();
 
-        fmt::print("\nShutting down. Total messages received: {}\n", message_count);
-        shm::close_shm(ring_buffer);
+        alog::AsyncLogger::instance().stop();
+        fmt::print("\nShutting down. Total messages received: {} (log records dropped: {})\n",
+            handler.message_count(), alog::AsyncLogger::instance().dropped());
+        if (handler.message_count() > 0) {
+            fmt::print("Latency: {} (avg {} ns)\n", handler.transport().percentiles(), handler.transport().mean());
+            fmt::print("Throughput: {:.0f} msg/s\n", handler.throughput());
+            fmt::print("Stage breakdown (publish -> read is the line above):\n");
+            fmt::print("  read -> decode:    {}\n", handler.read_to_decode().percentiles());
+            fmt::print("  decode -> handle:  {}\n", handler.decode_to_handle().percentiles());
+            fmt::print("  publish -> handle: {}\n", handler.end_to_end().percentiles());
+        }
+        if (hist_out != nullptr) {
+            if (handler.transport().dump(hist_out)) {
+                fmt::print("Latency histogram written to {}\n", hist_out);
+            } else {
+                fmt::print("Warning: Could not write histogram to {}\n", hist_out);
+            }
+        }
+        shm::close_shm(segment);
 
     } catch (std::exception& e) {
         fmt::print("Error: {}\n", e.what());
@@ -1,15 +1,27 @@
 #include <iostream>
+#include <algorithm>
 #include <cstring>
+#include <string_view>
 #include <boost/asio.hpp>
 #include <fmt/core.h>
 #include <csignal>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/socket.h>
+#include "../include/async_log.h"
+#include "../include/latency_histogram.h"
 #include "../include/market_data.h"
+#include "../include/shm_helper.h"
+#include "../include/instruments.h"
+#include "../include/feed_parser.h"
 #include "../include/utils.h"
 
 using boost::asio::ip::tcp;
 
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
 volatile sig_atomic_t running = 1;
 
 void signal_handler(int signal) {
@@ -28,13 +40,55 @@ inline bool set_cpu_affinity(int cpu_id) {
 
 int main(int argc, char* argv[]) {
     int cpu_core = 3;  // Default: separate from others
+    const char* port = "8080";
+    const char* symbols = nullptr;  // Default: every instrument
+    bool conflate = false;
+    bool compact = false;
+    bool busy_wait = false;
+    int busy_poll_us = 0;  // SO_BUSY_POLL budget; 0 leaves it off
+    int log_cpu = 5;       // Housekeeping core for the log thread
+    bool quiet = false;              // No per-message lines
+    uint64_t report_interval_s = 5;  // Percentile report period; 0: only at exit
+    const char* hist_out = nullptr;  // Dump the run's histogram here on exit
+    uint64_t count = 0;              // Exit after this many updates (0: never)
+    const char* shm_name = shm::SHM_NAME;  // Only read for the publisher's clock
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
             cpu_core = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = argv[++i];
+        } else if (strcmp(argv[i], "--symbols") == 0 && i + 1 < argc) {
+            symbols = argv[++i];
+        } else if (strcmp(argv[i], "--conflate") == 0) {
+            conflate = true;
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            compact = true;
+        } else if (strcmp(argv[i], "--busy-wait") == 0 || strcmp(argv[i], "-b") == 0) {
+            busy_wait = true;
+        } else if (strcmp(argv[i], "--busy-poll-us") == 0 && i + 1 < argc) {
+            busy_poll_us = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--report-interval") == 0 && i + 1 < argc) {
+            report_interval_s = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--hist-out") == 0 && i + 1 < argc) {
+            hist_out = argv[++i];
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--log-cpu") == 0 && i + 1 < argc) {
+            log_cpu = std::atoi(argv[++i]);
         }
     }
 
+    uint64_t symbol_mask;
+    if (symbols != nullptr && !instruments::parse_symbol_list(symbols, symbol_mask)) {
+        fmt::print("Error: Unknown instrument in --symbols {}\n", symbols);
+        return 1;
+    }
+
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
@@ -47,10 +101,25 @@ int main(int argc, char* argv[]) {
             fmt::print("Warning: Could not set CPU affinity\n");
         }
 
+        if (alog::AsyncLogger::instance().start(log_cpu)) {
+            fmt::print("Log thread pinned to CPU {}\n", log_cpu);
+        } else {
+            fmt::print("Warning: Could not pin log thread to CPU {}\n", log_cpu);
+        }
+
+        if (shm::adopt_clock(shm_name)) {
+            fmt::print("Using publisher clock calibration from {}\n", shm_name);
+        }
+        if (tsc::active.valid) {
+            fmt::print("Clock: TSC at {:.3f} GHz\n", tsc::ghz(tsc::active));
+        } else {
+            fmt::print("Clock: system clock (TSC disabled or not invariant)\n");
+        }
+
         boost::asio::io_context io_context;
 
         tcp::resolver resolver(io_context);
-        auto endpoints = resolver.resolve("127.0.0.1", "8080");
+        auto endpoints = resolver.resolve("127.0.0.1", port);
 
         tcp::socket socket(io_context);
         boost::asio::connect(socket, endpoints);
@@ -58,50 +127,228 @@ int main(int argc, char* argv[]) {
         socket.set_option(tcp::no_delay(true));  // Disable Nagle's algorithm
         socket.set_option(boost::asio::socket_base::receive_buffer_size(65536));
 
-        fmt::print("Connected to publisher at 127.0.0.1:8080\n");
+        fmt::print("Connected to publisher at 127.0.0.1:{}\n", port);
+
+        if (busy_wait) {
+            socket.non_blocking(true);
+            fmt::print("Mode: BUSY-WAIT (non-blocking recv spin, high CPU usage)\n");
+        } else {
+            fmt::print("Mode: BLOCKING (sleep in recv until data arrives)\n");
+        }
+        if (busy_poll_us > 0) {
+            // Let the kernel poll the device queue instead of waiting for an
+            // interrupt; values above net.core.busy_poll need CAP_NET_ADMIN
+            int prefer = 1;
+            if (setsockopt(socket.native_handle(), SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us)) == 0 &&
+                setsockopt(socket.native_handle(), SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) == 0) {
+                fmt::print("SO_BUSY_POLL set: {} us\n", busy_poll_us);
+            } else {
+                fmt::print("Warning: Could not set SO_BUSY_POLL: {}\n", std::strerror(errno));
+            }
+        }
+
+        // Control commands; see Server in publisher.cpp for the protocol
+        std::string commands;
+        if (symbols != nullptr) {
+            commands += "UNSUB *\nSUB " + std::string(symbols) + "\n";
+            fmt::print("Subscribing to {}\n", symbols);
+        }
+        if (conflate) {
+            commands += "CONFLATE ON\n";
+            fmt::print("Requesting conflation\n");
+        }
+        if (compact) {
+            commands += "ENCODING COMPACT\n";
+            fmt::print("Requesting compact encoding\n");
+        }
+        if (!commands.empty()) {
+            boost::asio::write(socket, boost::asio::buffer(commands));
+        }
+
+        // Sequence numbers are publisher-wide, so they are only gap-free
+        // when receiving every instrument without conflation
+        bool check_gaps = symbols == nullptr && !conflate;
         fmt::print("Consumer ready. Waiting for market data over TCP...\n");
 
         uint64_t message_count = 0;
+        uint64_t expected_seq = 0;
+        uint64_t gap_count = 0;
+        uint64_t bad_json = 0;
+        uint64_t oversized = 0;
+        uint32_t snapshot_remaining = 0;
+        uint64_t bytes_received = 0;
+        uint64_t recv_calls = 0;
+        uint64_t empty_polls = 0;
+        uint64_t first_receive_ts = 0;
+        uint64_t last_receive_ts = 0;
+        LatencyHistogram histogram;  // Whole run
+        LatencyHistogram interval;   // Since the last report
+        LatencyHistogram wakeup;     // First frame of each recv
+        const uint64_t report_interval_ns = report_interval_s * 1'000'000'000;
+        uint64_t next_report_ns = report_interval_ns > 0
+            ? utils::get_timestamp_ns() + report_interval_ns : UINT64_MAX;
 
-        while (running) {
-            boost::asio::streambuf buffer;
-            boost::system::error_code ec;
-
-            boost::asio::read_until(socket, buffer, '\n', ec);
+        // Persistent buffer: one recv may pull in several frames at once,
+        // and a partial frame stays put until the rest arrives
+        RecvBuffer buffer;
+        feed::FeedParser parser;
+        const int fd = socket.native_handle();
+        bool eof = false;
+        int recv_errno = 0;
 
-            if (ec) {
-                if (ec == boost::asio::error::eof) {
-                    fmt::print("Connection closed by publisher\n");
-                } else {
-                    fmt::print("Error reading from socket: {}\n", ec.message());
+        while (running) {
+            char* tail = buffer.write_ptr();
+            if (buffer.write_space() == 0) {
+                // A line longer than the buffer never completes; without
+                // this recv would be asked for 0 bytes and read as EOF
+                oversized++;
+                alog::log(FMT_STRING("Warning: Frame larger than the {} byte receive buffer, "
+                                     "skipping to the next line\n"), buffer.size());
+                parser.discard_oversized(buffer);
+                continue;
+            }
+            ssize_t n = ::recv(fd, tail, buffer.write_space(), 0);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    empty_polls++;  // Busy-wait mode: nothing yet, spin
+                    continue;
                 }
+                if (errno == EINTR) {
+                    continue;
+                }
+                recv_errno = errno;
+                break;
+            }
+            if (n == 0) {
+                eof = true;
                 break;
             }
-
             uint64_t receive_ts = utils::get_timestamp_ns();
+            buffer.commit(n);
+            bytes_received += n;
+            recv_calls++;
+            bool first_in_recv = true;
+
+            // Handle every complete frame in the buffer
+            feed::FrameType type;
+            while ((type = parser.next(buffer)) != feed::FrameType::NEED_MORE) {
+                if (type == feed::FrameType::SNAPSHOT) {
+                    alog::log(FMT_STRING("Snapshot at seq {}: {} instruments\n"),
+                        parser.snapshot_seq(), parser.snapshot_count());
+                    snapshot_remaining = parser.snapshot_count();
+                    expected_seq = parser.snapshot_seq() + 1;
+                    continue;
+                }
+                if (type == feed::FrameType::BAD_COMPACT) {
+                    alog::log(FMT_STRING("Warning: Undecodable compact frame, waiting for keyframe\n"));
+                    continue;
+                }
+                if (type == feed::FrameType::BAD_JSON) {
+                    // The line itself does not outlive the buffer; log a copy
+                    // of its start
+                    char excerpt[64] = {};
+                    std::memcpy(excerpt, parser.bad_frame(), std::min(parser.bad_frame_size(), sizeof(excerpt)));
+                    alog::log(FMT_STRING("Warning: Failed to parse JSON: {}\n"), excerpt);
+                    bad_json++;
+                    continue;
+                }
+                const MarketData& data = parser.data();
+
+                if (snapshot_remaining > 0) {
+                    snapshot_remaining--;
+                    if (!quiet) {
+                        alog::log(FMT_STRING("[{}] {} BID={:.2f} ASK={:.2f} (snapshot, seq {})\n"),
+                            alog::Timestamp{receive_ts},
+                            data.instrument,
+                            data.bid,
+                            data.ask,
+                            data.seq_num);
+                    }
+                    continue;
+                }
 
-            std::istream is(&buffer);
-            std::string json_message;
-            std::getline(is, json_message);
+                if (check_gaps && data.seq_num != expected_seq) {
+                    if (data.seq_num > expected_seq) {
+                        gap_count += data.seq_num - expected_seq;
+                        alog::log(FMT_STRING("Warning: Sequence gap, expected {} got {}\n"),
+                            expected_seq, data.seq_num);
+                    } else {
+                        alog::log(FMT_STRING("Warning: Duplicate/stale seq {} (expected {})\n"),
+                            data.seq_num, expected_seq);
+                        continue;
+                    }
+                }
+                expected_seq = data.seq_num + 1;
 
-            MarketData data;
-            if (utils::from_json(json_message, data)) {
                 uint64_t latency_ns = receive_ts - data.timestamp_ns;
+                interval.record(latency_ns);
 
-                fmt::print("[{}] {} BID={:.2f} ASK={:.2f} (latency: {} ns)\n",
-                    utils::format_timestamp(receive_ts),
-                    data.instrument,
-                    data.bid,
-                    data.ask,
-                    latency_ns);
+                // Wake-up latency: the first frame of a recv had nothing
+                // queued ahead of it, so its latency is publish-to-wake
+                if (first_in_recv) {
+                    first_in_recv = false;
+                    wakeup.record(latency_ns);
+                }
 
-                message_count++;
-            } else {
-                fmt::print("Warning: Failed to parse JSON: {}\n", json_message);
+                if (!quiet) {
+                    alog::log(FMT_STRING("[{}] {} BID={:.2f} ASK={:.2f} (latency: {} ns)\n"),
+                        alog::Timestamp{receive_ts},
+                        data.instrument,
+                        data.bid,
+                        data.ask,
+                        latency_ns);
+                }
+
+                if (receive_ts >= next_report_ns) {
+                    alog::log(FMT_STRING("Latency: {}\n"), interval.percentiles());
+                    histogram.merge(interval);
+                    interval.reset();
+                    next_report_ns = receive_ts + report_interval_ns;
+                }
+
+                if (message_count++ == 0) {
+                    first_receive_ts = receive_ts;
+                }
+                last_receive_ts = receive_ts;
+                if (message_count == count) {
+                    running = 0;
+                    break;
+                }
             }
         }
 
-        fmt::print("\nShutting down. Total messages received: {}\n", message_count);
+        alog::AsyncLogger::instance().stop();
+        if (eof) {
+            fmt::print("Connection closed by publisher\n");
+        } else if (recv_errno != 0) {
+            fmt::print("Error reading from socket: {}\n", std::strerror(recv_errno));
+        }
+
+        fmt::print("\nShutting down. Total messages received: {} (sequence gaps: {}, log records dropped: {})\n",
+            message_count, gap_count, alog::AsyncLogger::instance().dropped());
+        if (bad_json > 0 || oversized > 0) {
+            fmt::print("Frames skipped: {} unparseable, {} oversized\n", bad_json, oversized);
+        }
+        histogram.merge(interval);
+        if (message_count > 0) {
+            fmt::print("Bytes/message: {:.1f}, {:.2f} messages/recv\n",
+                static_cast<double>(bytes_received) / message_count,
+                static_cast<double>(message_count) / recv_calls);
+            fmt::print("Latency: {} (avg {} ns)\n", histogram.percentiles(), histogram.mean());
+            fmt::print("Throughput: {:.0f} msg/s\n", last_receive_ts > first_receive_ts
+                ? static_cast<double>(message_count - 1) * 1e9 / static_cast<double>(last_receive_ts - first_receive_ts) : 0.0);
+            fmt::print("Wake-up: {} (avg {} ns)\n", wakeup.percentiles(), wakeup.mean());
+        }
+        if (hist_out != nullptr) {
+            if (histogram.dump(hist_out)) {
+                fmt::print("Latency histogram written to {}\n", hist_out);
+            } else {
+                fmt::print("Warning: Could not write histogram to {}\n", hist_out);
+            }
+        }
+        if (busy_wait) {
+            fmt::print("Empty polls: {}\n", empty_polls);
+        }
 
     } catch (std::exception& e) {
         fmt::print("Error: {}\n", e.what());
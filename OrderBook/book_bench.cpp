@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "map_order_book.h"
+#include "order_book.h"
+#include "order_flow.h"
+#include "order_index.h"
+
+// Price-ladder OrderBook against the std::map baseline on the same
+// synthetic flow (order_flow.h): 1M add/cancel/amend operations holding
+// the book near 1k, 10k or 100k live orders. BM_Cancel compares the
+// order-ID index on its own against std::unordered_map.
+
+namespace {
+
+constexpr size_t FLOW_OPS = 1'000'000;
+
+const std::vector<BookOp>& flow(size_t live_target) {
+    static std::map<size_t, std::vector<BookOp>> cache;
+    auto it = cache.find(live_target);
+    if (it == cache.end()) {
+        it = cache.emplace(live_target, make_order_flow(FLOW_OPS, live_target)).first;
+    }
+    return it->second;
+}
+
+template<typename Book>
+void BM_OrderFlow(benchmark::State& state) {
+    const std::vector<BookOp>& ops = flow(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Book>();
+        state.ResumeTiming();
+        for (const BookOp& op : ops) {
+            apply(*book, op);
+        }
+        benchmark::ClobberMemory();
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ops.size()));
+}
+BENCHMARK_TEMPLATE(BM_OrderFlow, MapOrderBook)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderFlow, OrderBook)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond);
+
+// Top-10 levels per side from a book holding the flow's final state
+template<typename Book>
+void BM_Snapshot(benchmark::State& state) {
+    Book book;
+    for (const BookOp& op : flow(static_cast<size_t>(state.range(0)))) {
+        apply(book, op);
+    }
+    std::vector<PriceLevel> bids, asks;
+    for (auto _ : state) {
+        book.get_snapshot(10, bids, asks);
+        benchmark::DoNotOptimize(bids.data());
+        benchmark::DoNotOptimize(asks.data());
+    }
+}
+BENCHMARK_TEMPLATE(BM_Snapshot, MapOrderBook)->Arg(10'000);
+BENCHMARK_TEMPLATE(BM_Snapshot, OrderBook)->Arg(10'000);
+
+// The incrementally maintained top levels, copied out whole
+void BM_TopSnapshot(benchmark::State& state) {
+    OrderBook book;
+    for (const BookOp& op : flow(static_cast<size_t>(state.range(0)))) {
+        apply(book, op);
+    }
+    DepthSnapshot top;
+    for (auto _ : state) {
+        book.get_top(top);
+        benchmark::DoNotOptimize(&top);
+    }
+}
+BENCHMARK(BM_TopSnapshot)->Arg(10'000);
+
+// Cancel every one of 1M live orders (sequential exchange-style IDs) in
+// random order; the index is refilled outside the timed region. Time per
+// item is the cost of one cancel's lookup and erase.
+constexpr size_t INDEX_ORDERS = 1'000'000;
+
+struct MapIndex {
+    std::unordered_map<uint64_t, OrderBook::OrderRef> map;
+    explicit MapIndex(size_t expected) { map.reserve(expected); }
+    void insert(uint64_t id, const OrderBook::OrderRef& ref) { map[id] = ref; }
+    bool erase(uint64_t id) { return map.erase(id) != 0; }
+};
+
+struct HashedIndex {
+    OrderIndex<OrderBook::OrderRef> index;
+    explicit HashedIndex(size_t expected) : index(expected) {}
+    void insert(uint64_t id, const OrderBook::OrderRef& ref) { index.insert_or_assign(id, ref); }
+    bool erase(uint64_t id) { return index.erase(id); }
+};
+
+struct DirectIndex {
+    OrderIndex<OrderBook::OrderRef> index;
+    explicit DirectIndex(size_t expected) : index(expected, expected + 1) {}
+    void insert(uint64_t id, const OrderBook::OrderRef& ref) { index.insert_or_assign(id, ref); }
+    bool erase(uint64_t id) { return index.erase(id); }
+};
+
+template<typename Index>
+void BM_Cancel(benchmark::State& state) {
+    std::vector<uint64_t> ids(INDEX_ORDERS);
+    std::iota(ids.begin(), ids.end(), 1);
+    std::vector<uint64_t> cancels = ids;
+    std::shuffle(cancels.begin(), cancels.end(), std::mt19937_64(42));
+
+    Index index(INDEX_ORDERS);
+    auto fill = [&] {
+        for (uint64_t id : ids) {
+            index.insert(id, OrderBook::OrderRef{(id & 1) != 0, static_cast<int64_t>(id % 512), nullptr});
+        }
+    };
+    fill();
+    for (auto _ : state) {
+        for (uint64_t id : cancels) {
+            benchmark::DoNotOptimize(index.erase(id));
+        }
+        state.PauseTiming();
+        fill();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(cancels.size()));
+}
+BENCHMARK_TEMPLATE(BM_Cancel, MapIndex)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Cancel, HashedIndex)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Cancel, DirectIndex)->Unit(benchmark::kMillisecond);
+
+// Fail the run if the two books disagree on the final depth. Every 1000th
+// add is followed by a re-add of its id at another price, which both books
+// must reject. The all-ones id is reserved by OrderIndex: it must be
+// refused and then reported unknown, not matched against an empty slot.
+bool books_match() {
+    for (uint64_t directids : {uint64_t{0}, uint64_t{1} << 16}) {
+        OrderBook book(0.01, 4096, 1024, directids);
+        const uint64_t reserved = OrderIndex<OrderBook::OrderRef>::EMPTY;
+        int64_t tick = 0;
+        if (book.addorder(Order{reserved, true, 100.0, 10, 0}) || book.cancelorder(reserved)
+            || book.executeorder(reserved, 1) || book.amendorder(reserved, 100.0, 5)
+            || book.find(reserved, tick) != nullptr || book.order_count() != 0) {
+            return false;
+        }
+    }
+    for (size_t live_target : {1'000, 10'000}) {
+        MapOrderBook reference;
+        OrderBook book;
+        size_t adds = 0;
+        for (const BookOp& op : flow(live_target)) {
+            apply(reference, op);
+            apply(book, op);
+            if (op.type == BookOp::ADD && ++adds % 1000 == 0) {
+                Order duplicate = op.order;
+                duplicate.price += 0.05;
+                if (reference.addorder(duplicate) || book.addorder(duplicate)) {
+                    return false;
+                }
+            }
+        }
+        auto same = [](const std::vector<PriceLevel>& a, const std::vector<PriceLevel>& b) {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); i++) {
+                if (a[i].price != b[i].price || a[i].totalquantity != b[i].totalquantity) return false;
+            }
+            return true;
+        };
+        // 10 levels come from the top array, 50 from walking the ladder
+        for (size_t depth : {10, 50}) {
+            std::vector<PriceLevel> ref_bids, ref_asks, bids, asks;
+            reference.get_snapshot(depth, ref_bids, ref_asks);
+            book.get_snapshot(depth, bids, asks);
+            if (!same(ref_bids, bids) || !same(ref_asks, asks)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!books_match()) {
+        std::fprintf(stderr, "OrderBook and MapOrderBook disagree on the final book\n");
+        return 1;
+    }
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
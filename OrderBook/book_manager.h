@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include "matching_engine.h"
+#include "order_book.h"
+#include "spsc_queue.h"
+
+// Multi-instrument book manager
+//
+// Instruments (dense ids 0..symbols-1) are partitioned across N worker
+// threads by symbol % N, each worker optionally pinned to a CPU. A worker
+// owns the books of its instruments outright: it creates them and is the
+// only thread that ever touches them, so nothing on the book path takes a
+// lock. One dispatcher thread routes operations to the owning worker through
+// that worker's SPSC input queue; an instrument always goes to the same
+// worker through one FIFO, so its operations are applied in submission
+// order. Each worker answers every operation with a BookResult on its own
+// SPSC output queue, which one consumer thread drains through poll(). A
+// worker waits while its output queue is full; once stop() has been called
+// it drops the result instead (counted in dropped_results()), so shutting
+// down never hangs on a consumer that has stopped draining.
+
+struct BookRequest {
+    uint32_t symbol;
+    uint64_t sequence;      // Per instrument, assigned by the dispatcher
+    BookOp op;
+};
+
+struct BookResult {
+    uint32_t symbol;
+    uint64_t sequence;
+    uint64_t orderid;
+    BookOp::Type type;
+    bool accepted;          // ADD: not rejected; CANCEL/AMEND: the order was resting
+    uint32_t trades;
+    uint64_t filled;        // Quantity the operation traded
+    PriceLevel bestbid;     // Top of book afterwards, zero if the side is empty
+    PriceLevel bestask;
+};
+
+struct BookManagerConfig {
+    size_t shards = 1;
+    std::vector<int> cpus;          // Worker i is pinned to cpus[i], if present and >= 0
+    size_t queuecapacity = 65536;   // Per queue, each direction
+    size_t expectedorders = 4096;   // Per book
+    double ticksize = 0.01;
+    bool busywait = false;          // Idle workers spin instead of yielding
+};
+
+class BookManager {
+public:
+    BookManager(size_t symbols, const BookManagerConfig& config)
+        : config_(config), sequence_(symbols, 0) {
+        size_t count = config.shards > 0 ? config.shards : 1;
+        for (size_t i = 0; i < count; i++) {
+            shards_.push_back(std::make_unique<Shard>(config.queuecapacity));
+        }
+        for (size_t i = 0; i < count; i++) {
+            shards_[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    ~BookManager() { stop(); }
+
+    BookManager(const BookManager&) = delete;
+    BookManager& operator=(const BookManager&) = delete;
+
+    size_t shards() const { return shards_.size(); }
+    size_t shard_of(uint32_t symbol) const { return symbol % shards_.size(); }
+
+    enum class Submit { OK, FULL, UNKNOWN_SYMBOL };
+
+    // Dispatcher thread only; FULL means the owning worker's queue is full
+    // and the same call can be retried
+    Submit try_submit(uint32_t symbol, const BookOp& op) {
+        if (symbol >= sequence_.size()) {
+            return Submit::UNKNOWN_SYMBOL;
+        }
+        BookRequest request{symbol, sequence_[symbol], op};
+        if (!shards_[shard_of(symbol)]->input.try_push(request)) {
+            return Submit::FULL;
+        }
+        sequence_[symbol]++;
+        return Submit::OK;
+    }
+
+    // One consumer thread per shard; false if no result is waiting
+    bool poll(size_t shard, BookResult& result) {
+        return shards_[shard]->output.try_pop(result);
+    }
+
+    // Results workers discarded because their output queue was full after
+    // stop() had been called
+    uint64_t dropped_results() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Workers finish what is queued, then exit
+    void stop() {
+        running_.store(false, std::memory_order_release);
+        for (auto& shard : shards_) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+    }
+
+private:
+    struct Instrument {
+        OrderBook book;
+        MatchingEngine engine;
+
+        Instrument(double ticksize, size_t expectedorders)
+            : book(ticksize, 4096, expectedorders), engine(book) {}
+    };
+
+    struct Shard {
+        SpscQueue<BookRequest> input;
+        SpscQueue<BookResult> output;
+        std::thread thread;
+
+        explicit Shard(size_t capacity) : input(capacity), output(capacity) {}
+    };
+
+    void idle() const {
+        if (!config_.busywait) {
+            std::this_thread::yield();
+        }
+    }
+
+    void run(size_t index) {
+        if (index < config_.cpus.size() && config_.cpus[index] >= 0) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(config_.cpus[index], &cpuset);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        }
+        Shard& shard = *shards_[index];
+        size_t stride = shards_.size();
+
+        // Created here, after pinning, so each book's memory is first
+        // touched by the thread that uses it
+        std::vector<std::unique_ptr<Instrument>> books;
+        for (size_t symbol = index; symbol < sequence_.size(); symbol += stride) {
+            books.push_back(std::make_unique<Instrument>(config_.ticksize, config_.expectedorders));
+        }
+
+        BookRequest request;
+        while (true) {
+            if (!shard.input.try_pop(request)) {
+                if (!running_.load(std::memory_order_acquire) && shard.input.empty()) {
+                    break;
+                }
+                idle();
+                continue;
+            }
+            Instrument& instrument = *books[request.symbol / stride];
+            BookResult result{request.symbol, request.sequence, request.op.order.orderid,
+                request.op.type, true, 0, 0, PriceLevel{}, PriceLevel{}};
+            switch (request.op.type) {
+            case BookOp::ADD:
+                result.filled = instrument.engine.submit(request.op.order);
+                result.accepted = instrument.engine.events().empty()
+                    || instrument.engine.events().front().type != MatchEvent::REJECT;
+                break;
+            case BookOp::CANCEL:
+                result.accepted = instrument.engine.cancel(request.op.order.orderid);
+                break;
+            case BookOp::AMEND:
+                result.accepted = instrument.engine.amend(request.op.order.orderid, request.op.order.price,
+                    request.op.order.quantity, request.op.order.timestampns);
+                break;
+            }
+            for (const MatchEvent& event : instrument.engine.events()) {
+                if (event.type == MatchEvent::TRADE) {
+                    result.trades++;
+                    if (request.op.type != BookOp::ADD) {
+                        result.filled += event.quantity;    // A re-priced amend that crossed
+                    }
+                }
+            }
+            instrument.book.best_bid(result.bestbid);
+            instrument.book.best_ask(result.bestask);
+
+            while (!shard.output.try_push(result)) {
+                if (!running_.load(std::memory_order_acquire)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+                idle();
+            }
+        }
+    }
+
+    BookManagerConfig config_;
+    std::vector<uint64_t> sequence_;    // Next sequence per instrument (dispatcher only)
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> running_{true};
+    std::atomic<uint64_t> dropped_{0};
+};
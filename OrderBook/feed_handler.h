@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "itch.h"
+#include "order_book.h"
+
+// Market-by-order feed handler
+//
+// Applies ITCH-style order messages (itch.h) to one OrderBook per
+// instrument, indexed by stock locate. The exchange has already matched
+// these orders, so executions arrive as messages and go straight to the
+// book; nothing here matches. A book is created on the first add for its
+// locate. Messages are decoded in place from the caller's buffer.
+//
+// Prices go from the 4-decimal integer on the wire straight to ticks with
+// integer arithmetic, never through a double. A price that is not a whole
+// number of ticks (a sub-penny stub quote on a 0.01 book) would otherwise
+// be merged into a neighbouring level, so such an add is counted as off
+// grid and not applied; pass a finer tick size to keep those prices.
+//
+// References to unknown orders (a feed joined mid-session, or a gap) are
+// counted and otherwise ignored, as are messages shorter than their type's
+// layout.
+
+struct FeedStats {
+    uint64_t messages = 0;
+    uint64_t adds = 0;
+    uint64_t executes = 0;
+    uint64_t cancels = 0;
+    uint64_t deletes = 0;
+    uint64_t replaces = 0;
+    uint64_t skipped = 0;       // Types the handler does not apply
+    uint64_t unknown = 0;       // Referenced an order not in the book
+    uint64_t offgrid = 0;       // Add or replace price not a whole number of ticks
+    uint64_t malformed = 0;     // Shorter than the layout of its type
+};
+
+class FeedHandler {
+public:
+    // ticksize must be a whole number of 1/10000 price units
+    explicit FeedHandler(double ticksize = 0.01, size_t expectedorders = 4096)
+        : ticksize_(ticksize),
+          pricepertick_(std::max<int64_t>(1, std::llround(ticksize * itch::PRICE_SCALE))),
+          expectedorders_(expectedorders), books_(65536), symbols_(65536) {}
+
+    // Apply one message of length bytes (without its length prefix)
+    void handle(const uint8_t* message, size_t length) {
+        stats_.messages++;
+        if (length == 0 || length < layout_size(static_cast<char>(message[0]))) {
+            stats_.malformed++;
+            return;
+        }
+        const auto* header = reinterpret_cast<const itch::Header*>(message);
+        switch (header->type) {
+        case 'A': {
+            const auto* m = reinterpret_cast<const itch::AddOrder*>(message);
+            stats_.adds++;
+            int64_t tick = 0;
+            if (!price_to_tick(m->price(), tick)) {
+                stats_.offgrid++;
+                break;
+            }
+            OrderBook& book = book_for(header->stock_locate(), m->stock);
+            book.addorder(Order{m->order_ref(), m->isbuy(), book.to_price(tick),
+                                m->shares(), header->timestamp_ns()}, tick);
+            break;
+        }
+        case 'E': {
+            const auto* m = reinterpret_cast<const itch::OrderExecuted*>(message);
+            OrderBook* book = books_[header->stock_locate()].get();
+            stats_.executes++;
+            if (book == nullptr || !book->executeorder(m->order_ref(), m->shares())) {
+                stats_.unknown++;
+            }
+            break;
+        }
+        case 'X': {
+            // A partial cancel takes quantity off the order just like a fill
+            const auto* m = reinterpret_cast<const itch::OrderCancel*>(message);
+            OrderBook* book = books_[header->stock_locate()].get();
+            stats_.cancels++;
+            if (book == nullptr || !book->executeorder(m->order_ref(), m->shares())) {
+                stats_.unknown++;
+            }
+            break;
+        }
+        case 'D': {
+            const auto* m = reinterpret_cast<const itch::OrderDelete*>(message);
+            OrderBook* book = books_[header->stock_locate()].get();
+            stats_.deletes++;
+            if (book == nullptr || !book->cancelorder(m->order_ref())) {
+                stats_.unknown++;
+            }
+            break;
+        }
+        case 'U': {
+            const auto* m = reinterpret_cast<const itch::OrderReplace*>(message);
+            OrderBook* book = books_[header->stock_locate()].get();
+            stats_.replaces++;
+            int64_t tick = 0;
+            const OrderNode* node = book != nullptr ? book->find(m->original_ref(), tick) : nullptr;
+            if (node == nullptr) {
+                stats_.unknown++;
+                break;
+            }
+            // The original is gone either way; an off-grid replacement is
+            // not added, so later references to it count as unknown
+            bool isbuy = node->order.isbuy;
+            book->cancelorder(m->original_ref());
+            if (!price_to_tick(m->price(), tick)) {
+                stats_.offgrid++;
+                break;
+            }
+            book->addorder(Order{m->new_ref(), isbuy, book->to_price(tick),
+                                 m->shares(), header->timestamp_ns()}, tick);
+            break;
+        }
+        default:
+            stats_.skipped++;
+            break;
+        }
+    }
+
+    // Apply every complete length-prefixed message in [data, data + size);
+    // returns the bytes consumed
+    size_t handle_stream(const uint8_t* data, size_t size) {
+        size_t offset = 0;
+        while (offset + 2 <= size) {
+            size_t length = itch::load16(data + offset);
+            if (offset + 2 + length > size) break;
+            handle(data + offset + 2, length);
+            offset += 2 + length;
+        }
+        return offset;
+    }
+
+    const OrderBook* book(uint16_t locate) const { return books_[locate].get(); }
+    const std::string& symbol(uint16_t locate) const { return symbols_[locate]; }
+    const FeedStats& stats() const { return stats_; }
+
+    size_t book_count() const {
+        size_t count = 0;
+        for (const auto& book : books_) {
+            count += book != nullptr ? 1 : 0;
+        }
+        return count;
+    }
+
+private:
+    // Bytes a message of this type must have; 1 (just the type) for types
+    // that are skipped
+    static size_t layout_size(char type) {
+        switch (type) {
+        case 'A': return sizeof(itch::AddOrder);
+        case 'E': return sizeof(itch::OrderExecuted);
+        case 'X': return sizeof(itch::OrderCancel);
+        case 'D': return sizeof(itch::OrderDelete);
+        case 'U': return sizeof(itch::OrderReplace);
+        default: return 1;
+        }
+    }
+
+    bool price_to_tick(uint32_t price, int64_t& tick) const {
+        if (price % pricepertick_ != 0) return false;
+        tick = price / pricepertick_;
+        return true;
+    }
+
+    OrderBook& book_for(uint16_t locate, const char* stock) {
+        std::unique_ptr<OrderBook>& book = books_[locate];
+        if (book == nullptr) {
+            book = std::make_unique<OrderBook>(ticksize_, 4096, expectedorders_);
+            std::string name(stock, 8);
+            symbols_[locate] = name.substr(0, name.find_last_not_of(' ') + 1);
+        }
+        return *book;
+    }
+
+    double ticksize_;
+    int64_t pricepertick_;      // Wire price units (1/10000) per tick
+    size_t expectedorders_;
+    std::vector<std::unique_ptr<OrderBook>> books_;     // Indexed by stock locate
+    std::vector<std::string> symbols_;                 // From each book's first add
+    FeedStats stats_;
+};
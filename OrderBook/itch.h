@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// ITCH-style market-by-order messages
+//
+// The order messages of NASDAQ TotalView-ITCH 5.0, with the same byte
+// layout: packed, big-endian, prices as 4-implied-decimal integers and a
+// 6-byte nanoseconds-since-midnight timestamp. A stream is a sequence of
+// messages, each preceded by a 2-byte big-endian length, as in NASDAQ's
+// historical files, so a reader can skip types it does not handle.
+//
+// The structs overlay the raw bytes (they are only ever used through a
+// pointer into the buffer); the accessors do the byte swapping, so a
+// message is decoded in place, field by field, with no copy.
+
+namespace itch {
+
+inline uint16_t load16(const uint8_t* p) { uint16_t v; std::memcpy(&v, p, 2); return __builtin_bswap16(v); }
+inline uint32_t load32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return __builtin_bswap32(v); }
+inline uint64_t load64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return __builtin_bswap64(v); }
+inline uint64_t load48(const uint8_t* p) { return (static_cast<uint64_t>(load16(p)) << 32) | load32(p + 2); }
+
+inline void store16(uint8_t* p, uint16_t v) { v = __builtin_bswap16(v); std::memcpy(p, &v, 2); }
+inline void store32(uint8_t* p, uint32_t v) { v = __builtin_bswap32(v); std::memcpy(p, &v, 4); }
+inline void store64(uint8_t* p, uint64_t v) { v = __builtin_bswap64(v); std::memcpy(p, &v, 8); }
+inline void store48(uint8_t* p, uint64_t v) { store16(p, static_cast<uint16_t>(v >> 32)); store32(p + 2, static_cast<uint32_t>(v)); }
+
+constexpr double PRICE_SCALE = 10'000.0;   // Price fields carry 4 implied decimals
+
+#pragma pack(push, 1)
+
+struct Header {
+    char type;
+    uint8_t locate[2];      // Stock locate: dense per-instrument id
+    uint8_t tracking[2];
+    uint8_t timestamp[6];
+
+    uint16_t stock_locate() const { return load16(locate); }
+    uint64_t timestamp_ns() const { return load48(timestamp); }
+};
+
+struct AddOrder {          // 'A'
+    Header header;
+    uint8_t ref[8];
+    char side;              // 'B' or 'S'
+    uint8_t shares_[4];
+    char stock[8];          // Space padded
+    uint8_t price_[4];
+
+    uint64_t order_ref() const { return load64(ref); }
+    bool isbuy() const { return side == 'B'; }
+    uint32_t shares() const { return load32(shares_); }
+    uint32_t price() const { return load32(price_); }
+};
+
+struct OrderExecuted {     // 'E'
+    Header header;
+    uint8_t ref[8];
+    uint8_t shares_[4];
+    uint8_t match[8];
+
+    uint64_t order_ref() const { return load64(ref); }
+    uint32_t shares() const { return load32(shares_); }
+};
+
+struct OrderCancel {       // 'X': partial cancel
+    Header header;
+    uint8_t ref[8];
+    uint8_t shares_[4];
+
+    uint64_t order_ref() const { return load64(ref); }
+    uint32_t shares() const { return load32(shares_); }
+};
+
+struct OrderDelete {       // 'D'
+    Header header;
+    uint8_t ref[8];
+
+    uint64_t order_ref() const { return load64(ref); }
+};
+
+struct OrderReplace {      // 'U': new reference, price and size; loses priority
+    Header header;
+    uint8_t original[8];
+    uint8_t replacement[8];
+    uint8_t shares_[4];
+    uint8_t price_[4];
+
+    uint64_t original_ref() const { return load64(original); }
+    uint64_t new_ref() const { return load64(replacement); }
+    uint32_t shares() const { return load32(shares_); }
+    uint32_t price() const { return load32(price_); }
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(Header) == 11, "ITCH header is 11 bytes");
+static_assert(sizeof(AddOrder) == 36, "ITCH 'A' is 36 bytes");
+static_assert(sizeof(OrderExecuted) == 31, "ITCH 'E' is 31 bytes");
+static_assert(sizeof(OrderCancel) == 23, "ITCH 'X' is 23 bytes");
+static_assert(sizeof(OrderDelete) == 19, "ITCH 'D' is 19 bytes");
+static_assert(sizeof(OrderReplace) == 35, "ITCH 'U' is 35 bytes");
+
+// Fill in the common header of a message being encoded
+inline void encode_header(uint8_t* p, char type, uint16_t locate, uint64_t timestamp_ns) {
+    p[0] = static_cast<uint8_t>(type);
+    store16(p + 1, locate);
+    store16(p + 3, 0);
+    store48(p + 5, timestamp_ns);
+}
+
+} // namespace itch
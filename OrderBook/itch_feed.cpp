@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "feed_handler.h"
+
+// Replay an ITCH-style file (itch_gen, or a NASDAQ ITCH 5.0 file for the
+// order messages) from a memory mapping through FeedHandler into per-symbol
+// OrderBooks, decoding every message in place from the mapped pages.
+// Reports sustained messages/sec and, for one message in --sample, the time
+// from picking the message up to its book being updated.
+//
+//   ./itch_feed feed.itch [--populate] [--sample N] [--cpu N] [--expected-orders N]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool set_cpu_affinity(int cpu_id) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu_id, &cpuset);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    bool populate = false;
+    uint64_t sample = 64;
+    int cpu = -1;
+    size_t expected_orders = 4096;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--populate") == 0) {
+            populate = true;
+        } else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+            sample = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--expected-orders") == 0 && i + 1 < argc) {
+            expected_orders = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' && path.empty()) {
+            path = argv[i];
+        } else {
+            std::cout << "Usage: " << argv[0]
+                      << " file [--populate] [--sample N] [--cpu N] [--expected-orders N]\n";
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "Error: no input file\n";
+        return 1;
+    }
+    if (cpu >= 0 && !set_cpu_affinity(cpu)) {
+        std::cout << "Warning: Could not set CPU affinity\n";
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st{};
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "Error: cannot open " << path << "\n";
+        return 1;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error: mmap failed for " << path << "\n";
+        return 1;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    const auto* data = static_cast<const uint8_t*>(mapping);
+
+    FeedHandler handler(0.01, expected_orders);
+    std::vector<uint32_t> latencies;
+    latencies.reserve(size / 30 / sample + 1);
+
+    size_t offset = 0;
+    uint64_t n = 0;
+    auto start = Clock::now();
+    while (offset + 2 <= size) {
+        size_t length = itch::load16(data + offset);
+        if (offset + 2 + length > size) {
+            std::cerr << "Warning: truncated message at offset " << offset << "\n";
+            break;
+        }
+        const uint8_t* message = data + offset + 2;
+        offset += 2 + length;
+        if (++n % sample != 0) {
+            handler.handle(message, length);
+            continue;
+        }
+        auto t0 = Clock::now();
+        handler.handle(message, length);
+        latencies.push_back(static_cast<uint32_t>(std::min<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count(), UINT32_MAX)));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    munmap(mapping, size);
+
+    const FeedStats& stats = handler.stats();
+    std::cout << "File:         " << path << " (" << size / (1 << 20) << " MB"
+              << (populate ? ", pre-faulted" : "") << ")\n";
+    std::cout << "Messages:     " << stats.messages << " in " << std::fixed << std::setprecision(3)
+              << seconds << " s\n";
+    std::cout << "Throughput:   " << std::setprecision(0) << static_cast<double>(stats.messages) / seconds
+              << " msg/s, " << static_cast<double>(offset) / seconds / (1 << 20) << " MB/s\n";
+    std::cout << "By type:      A " << stats.adds << ", E " << stats.executes << ", X " << stats.cancels
+              << ", D " << stats.deletes << ", U " << stats.replaces << ", skipped " << stats.skipped << "\n";
+    std::cout << "Unknown refs: " << stats.unknown << ", off-grid prices " << stats.offgrid
+              << ", malformed " << stats.malformed << "\n";
+    size_t crossed = 0;
+    for (uint32_t locate = 0; locate < 65536; locate++) {
+        const OrderBook* book = handler.book(static_cast<uint16_t>(locate));
+        PriceLevel bid{}, ask{};
+        if (book != nullptr && book->best_bid(bid) && book->best_ask(ask)
+            && book->to_tick(bid.price) >= book->to_tick(ask.price)) {
+            crossed++;
+        }
+    }
+    std::cout << "Books:        " << handler.book_count() << " (" << crossed << " crossed)\n";
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        auto at = [&](double q) { return latencies[static_cast<size_t>(q * static_cast<double>(latencies.size() - 1))]; };
+        std::cout << "\nMessage to updated book (ns), 1 in " << sample << " sampled:\n";
+        std::cout << "  p50 " << at(0.50) << "  p90 " << at(0.90) << "  p99 " << at(0.99)
+                  << "  p99.9 " << at(0.999) << "  max " << latencies.back() << "\n";
+    }
+
+    std::cout << std::defaultfloat << std::setprecision(6);
+    for (uint16_t locate = 1; locate < 4; locate++) {
+        const OrderBook* book = handler.book(locate);
+        if (book == nullptr) continue;
+        std::cout << "\n" << handler.symbol(locate) << " (" << book->order_count() << " orders)\n";
+        book->print_book(5);
+    }
+    return 0;
+}
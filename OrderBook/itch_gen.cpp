@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "itch.h"
+
+// Synthetic ITCH-style market-by-order file for itch_feed
+//
+// Streams add/execute/cancel/delete/replace messages for a set of
+// instruments straight to disk, so the file can be far larger than memory.
+// Each instrument's mid random-walks; adds rest a few ticks from it and
+// every other message refers to one of that instrument's live orders, so
+// a correct handler never sees an unknown reference. When the mid moves it
+// trades through whatever now sits on the wrong side of it (executions in
+// full), so the books never cross.
+//
+//   ./itch_gen -o feed.itch [--size-gb 2] [--messages N] [--symbols N] [--live N] [--seed N]
+
+namespace {
+
+struct Live {
+    uint64_t ref;
+    bool isbuy;
+    int64_t tick;
+    uint32_t shares;
+};
+
+struct Instrument {
+    char stock[8];
+    int64_t mid;
+    std::vector<Live> live;
+};
+
+class Writer {
+public:
+    explicit Writer(FILE* file) : file_(file), buffer_(1 << 20) {}
+    ~Writer() { flush(); }
+
+    // Space for a length-prefixed message of size bytes
+    uint8_t* reserve(size_t size) {
+        if (used_ + 2 + size > buffer_.size()) {
+            flush();
+        }
+        uint8_t* p = buffer_.data() + used_;
+        itch::store16(p, static_cast<uint16_t>(size));
+        used_ += 2 + size;
+        written_ += 2 + size;
+        return p + 2;
+    }
+
+    void flush() {
+        if (used_ > 0 && std::fwrite(buffer_.data(), 1, used_, file_) != used_) {
+            ok_ = false;
+        }
+        used_ = 0;
+    }
+
+    uint64_t written() const { return written_; }
+    bool ok() const { return ok_; }
+
+private:
+    FILE* file_;
+    std::vector<uint8_t> buffer_;
+    size_t used_ = 0;
+    uint64_t written_ = 0;
+    bool ok_ = true;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    double size_gb = 2.0;
+    uint64_t messages = 0;
+    size_t symbols = 100;
+    size_t live_target = 2'000;
+    uint64_t seed = 42;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--size-gb") == 0 && i + 1 < argc) {
+            size_gb = std::strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc) {
+            messages = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--symbols") == 0 && i + 1 < argc) {
+            symbols = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            live_target = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cout << "Usage: " << argv[0]
+                      << " -o file [--size-gb 2] [--messages N] [--symbols N] [--live N] [--seed N]\n";
+            return 1;
+        }
+    }
+    if (path.empty() || symbols == 0 || symbols > 65535) {
+        std::cerr << "Error: need -o and 1..65535 symbols\n";
+        return 1;
+    }
+    uint64_t size_limit = messages > 0 ? UINT64_MAX : static_cast<uint64_t>(size_gb * (1ull << 30));
+    if (messages == 0) {
+        messages = UINT64_MAX;
+    }
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Error: cannot open " << path << "\n";
+        return 1;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::exponential_distribution<double> distance(1.0 / 6.0);
+    std::uniform_int_distribution<uint32_t> lots(1, 10);
+    std::uniform_int_distribution<size_t> pick_symbol(0, symbols - 1);
+
+    std::vector<Instrument> instruments(symbols);
+    for (size_t s = 0; s < symbols; s++) {
+        char name[9];
+        std::snprintf(name, sizeof(name), "SYM%-5zu", s);
+        std::memcpy(instruments[s].stock, name, 8);
+        instruments[s].mid = 5'000 + static_cast<int64_t>(s) * 37;
+        instruments[s].live.reserve(live_target * 2);
+    }
+
+    Writer out(file);
+    uint64_t nextref = 1, match = 1, timestamp = 34'200'000'000'000ull;   // 09:30
+    uint64_t count = 0;
+    auto price_of = [](int64_t tick) { return static_cast<uint32_t>(tick * 100); };   // 0.01 ticks
+
+    while (count < messages && out.written() < size_limit) {
+        size_t s = pick_symbol(rng);
+        Instrument& inst = instruments[s];
+        auto locate = static_cast<uint16_t>(s + 1);
+        timestamp += 1 + static_cast<uint64_t>(unit(rng) * 200.0);
+        if (count % 64 == 0) {
+            inst.mid += unit(rng) < 0.5 ? -1 : 1;
+            for (size_t i = 0; i < inst.live.size();) {
+                const Live& order = inst.live[i];
+                if (order.isbuy ? order.tick < inst.mid : order.tick > inst.mid) {
+                    i++;
+                    continue;
+                }
+                uint8_t* p = out.reserve(sizeof(itch::OrderExecuted));
+                itch::encode_header(p, 'E', locate, timestamp);
+                itch::store64(p + 11, order.ref);
+                itch::store32(p + 19, order.shares);
+                itch::store64(p + 23, match++);
+                count++;
+                inst.live[i] = inst.live.back();
+                inst.live.pop_back();
+            }
+        }
+        auto away = [&](bool isbuy) {
+            int64_t d = 1 + static_cast<int64_t>(distance(rng));
+            return isbuy ? inst.mid - d : inst.mid + d;
+        };
+        count++;
+
+        double add_share = inst.live.size() < live_target ? 0.5 : 0.35;
+        double r = unit(rng);
+        if (inst.live.empty() || r < add_share) {
+            Live order{nextref++, unit(rng) < 0.5, 0, lots(rng) * 100};
+            order.tick = away(order.isbuy);
+            uint8_t* p = out.reserve(sizeof(itch::AddOrder));
+            itch::encode_header(p, 'A', locate, timestamp);
+            itch::store64(p + 11, order.ref);
+            p[19] = order.isbuy ? 'B' : 'S';
+            itch::store32(p + 20, order.shares);
+            std::memcpy(p + 24, inst.stock, 8);
+            itch::store32(p + 32, price_of(order.tick));
+            inst.live.push_back(order);
+            continue;
+        }
+
+        size_t pick = std::min(static_cast<size_t>(unit(rng) * static_cast<double>(inst.live.size())),
+                               inst.live.size() - 1);
+        Live& target = inst.live[pick];
+        double kind = (r - add_share) / (1.0 - add_share);
+        bool gone = false;
+        if (kind < 0.15) {
+            uint32_t shares = std::min(target.shares, lots(rng) * 100);
+            uint8_t* p = out.reserve(sizeof(itch::OrderExecuted));
+            itch::encode_header(p, 'E', locate, timestamp);
+            itch::store64(p + 11, target.ref);
+            itch::store32(p + 19, shares);
+            itch::store64(p + 23, match++);
+            target.shares -= shares;
+            gone = target.shares == 0;
+        } else if (kind < 0.25 && target.shares > 100) {
+            uint32_t shares = 100 * (1 + static_cast<uint32_t>(unit(rng) * (target.shares / 100 - 1)));
+            shares = std::min(shares, target.shares - 100);
+            uint8_t* p = out.reserve(sizeof(itch::OrderCancel));
+            itch::encode_header(p, 'X', locate, timestamp);
+            itch::store64(p + 11, target.ref);
+            itch::store32(p + 19, shares);
+            target.shares -= shares;
+        } else if (kind < 0.90) {
+            uint8_t* p = out.reserve(sizeof(itch::OrderDelete));
+            itch::encode_header(p, 'D', locate, timestamp);
+            itch::store64(p + 11, target.ref);
+            gone = true;
+        } else {
+            Live replaced{nextref++, target.isbuy, away(target.isbuy), lots(rng) * 100};
+            uint8_t* p = out.reserve(sizeof(itch::OrderReplace));
+            itch::encode_header(p, 'U', locate, timestamp);
+            itch::store64(p + 11, target.ref);
+            itch::store64(p + 19, replaced.ref);
+            itch::store32(p + 27, replaced.shares);
+            itch::store32(p + 31, price_of(replaced.tick));
+            target = replaced;
+        }
+        if (gone) {
+            target = inst.live.back();
+            inst.live.pop_back();
+        }
+    }
+    out.flush();
+    bool ok = out.ok() && std::fclose(file) == 0;
+    if (!ok) {
+        std::cerr << "Error: write to " << path << " failed\n";
+        return 1;
+    }
+    std::cout << "Wrote " << count << " messages (" << out.written() / (1 << 20) << " MB) for "
+              << symbols << " instruments to " << path << "\n";
+    return 0;
+}
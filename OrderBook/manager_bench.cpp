@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "book_manager.h"
+#include "order_flow.h"
+
+// Throughput of BookManager as the number of shards grows
+//
+// Every instrument gets its own synthetic flow (order_flow.h, some adds
+// crossing); the flows are interleaved in random order into one stream that
+// the main thread dispatches. A collector thread drains every shard's
+// results and checks that each instrument's results come back in exactly
+// the order they were submitted.
+//
+//   ./manager_bench [--shards 1,2,4] [--cpus 1,2,3,4] [--symbols N] [--ops N]
+//                   [--live N] [--aggressive F] [--busy-wait]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<int> parse_list(const char* text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<int> shard_counts{1, 2, 4};
+    std::vector<int> cpus;
+    size_t symbols = 64;
+    size_t count = 4'000'000;
+    size_t live_target = 1'000;
+    double aggressive = 0.1;
+    bool busy_wait = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shard_counts = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+            cpus = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--symbols") == 0 && i + 1 < argc) {
+            symbols = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            live_target = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--aggressive") == 0 && i + 1 < argc) {
+            aggressive = std::strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--busy-wait") == 0) {
+            busy_wait = true;
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--shards 1,2,4] [--cpus 1,2,3,4] [--symbols N] [--ops N]"
+                      << " [--live N] [--aggressive F] [--busy-wait]\n";
+            return 1;
+        }
+    }
+    if (symbols == 0) {
+        std::cerr << "Error: --symbols must be at least 1\n";
+        return 1;
+    }
+
+    std::cout << "Generating " << count << " operations over " << symbols << " instruments...\n";
+    size_t per_symbol = count / symbols;
+    std::vector<std::vector<BookOp>> flows;
+    for (size_t s = 0; s < symbols; s++) {
+        flows.push_back(make_order_flow(per_symbol, live_target, static_cast<uint32_t>(42 + s),
+                                        0.01, 10'000, aggressive));
+    }
+    std::vector<uint32_t> stream;
+    stream.reserve(per_symbol * symbols);
+    for (size_t s = 0; s < symbols; s++) {
+        stream.insert(stream.end(), per_symbol, static_cast<uint32_t>(s));
+    }
+    std::shuffle(stream.begin(), stream.end(), std::mt19937_64(7));
+
+    std::cout << "\nShards   Orders/s      Trades   Out of order   Time (s)\n";
+    for (int shards : shard_counts) {
+        BookManagerConfig config;
+        config.shards = static_cast<size_t>(std::max(shards, 1));
+        config.cpus = cpus;
+        config.expectedorders = live_target * 4;
+        config.busywait = busy_wait;
+        BookManager manager(symbols, config);
+
+        uint64_t trades = 0, disorder = 0;
+        Clock::time_point finish;
+        std::thread collector([&] {
+            std::vector<uint64_t> expected(symbols, 0);
+            size_t received = 0;
+            BookResult result;
+            while (received < stream.size()) {
+                bool any = false;
+                for (size_t shard = 0; shard < manager.shards(); shard++) {
+                    while (manager.poll(shard, result)) {
+                        any = true;
+                        received++;
+                        trades += result.trades;
+                        if (result.sequence != expected[result.symbol]) {
+                            disorder++;
+                        }
+                        expected[result.symbol] = result.sequence + 1;
+                    }
+                }
+                if (!any && !busy_wait) {
+                    std::this_thread::yield();
+                }
+            }
+            finish = Clock::now();
+        });
+
+        std::vector<size_t> next(symbols, 0);
+        auto start = Clock::now();
+        for (uint32_t symbol : stream) {
+            const BookOp& op = flows[symbol][next[symbol]++];
+            while (manager.try_submit(symbol, op) == BookManager::Submit::FULL) {
+                if (!busy_wait) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        collector.join();
+        manager.stop();
+
+        double seconds = std::chrono::duration<double>(finish - start).count();
+        std::cout << std::setw(6) << config.shards
+                  << std::setw(11) << std::fixed << std::setprecision(0)
+                  << static_cast<double>(stream.size()) / seconds
+                  << std::setw(12) << trades
+                  << std::setw(15) << disorder
+                  << std::setw(11) << std::setprecision(3) << seconds << "\n";
+        if (disorder != 0) {
+            std::cerr << "Error: results for an instrument came back out of order\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "matching_engine.h"
+#include "order_flow.h"
+
+// Sustained throughput and per-order latency of MatchingEngine
+//
+// Replays a synthetic add/cancel/amend flow (order_flow.h) in which a share
+// of the adds cross the spread, timing every operation individually. Flow
+// generation and the latency buffers are set up before the clock starts.
+//
+//   ./match_bench [--ops N] [--live N] [--aggressive F]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void print_percentiles(const char* label, std::vector<uint32_t>& samples) {
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        size_t i = static_cast<size_t>(q * static_cast<double>(samples.size() - 1));
+        return samples[i];
+    };
+    std::cout << std::left << std::setw(10) << label << std::right
+              << std::setw(10) << samples.size()
+              << std::setw(8) << at(0.50)
+              << std::setw(8) << at(0.90)
+              << std::setw(8) << at(0.99)
+              << std::setw(9) << at(0.999)
+              << std::setw(10) << samples.back() << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = 5'000'000;
+    size_t live_target = 10'000;
+    double aggressive = 0.2;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            live_target = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--aggressive") == 0 && i + 1 < argc) {
+            aggressive = std::strtod(argv[++i], nullptr);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--ops N] [--live N] [--aggressive F]\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Generating " << count << " operations (live target " << live_target
+              << ", aggressive share " << aggressive << ")...\n";
+    const std::vector<BookOp> ops = make_order_flow(count, live_target, 42, 0.01, 10'000, aggressive);
+
+    OrderBook book(0.01, 4096, live_target * 2);
+    MatchingEngine engine(book);
+
+    // Latency samples (ns) by what the operation turned out to be
+    std::vector<uint32_t> passive, matched, cancels, amends;
+    passive.reserve(count);
+    matched.reserve(count);
+    cancels.reserve(count);
+    amends.reserve(count);
+
+    uint64_t trades = 0, events = 0, traded = 0, misses = 0;
+    auto start = Clock::now();
+    for (const BookOp& op : ops) {
+        auto t0 = Clock::now();
+        bool ok = true;
+        uint64_t filled = 0;
+        switch (op.type) {
+        case BookOp::ADD:
+            filled = engine.submit(op.order);
+            break;
+        case BookOp::CANCEL:
+            ok = engine.cancel(op.order.orderid);
+            break;
+        case BookOp::AMEND:
+            ok = engine.amend(op.order.orderid, op.order.price, op.order.quantity, op.order.timestampns);
+            break;
+        }
+        auto ns = static_cast<uint32_t>(std::min<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count(), UINT32_MAX));
+
+        for (const MatchEvent& event : engine.events()) {
+            if (event.type == MatchEvent::TRADE) {
+                trades++;
+                traded += event.quantity;
+            }
+        }
+        events += engine.events().size();
+        misses += ok ? 0 : 1;
+
+        switch (op.type) {
+        case BookOp::ADD:
+            (filled > 0 ? matched : passive).push_back(ns);
+            break;
+        case BookOp::CANCEL:
+            cancels.push_back(ns);
+            break;
+        case BookOp::AMEND:
+            amends.push_back(ns);
+            break;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "\nOperations:   " << ops.size() << " in " << std::fixed << std::setprecision(3)
+              << seconds << " s\n";
+    std::cout << "Throughput:   " << std::setprecision(0) << static_cast<double>(ops.size()) / seconds
+              << " orders/s (including per-op timing)\n";
+    std::cout << "Trades:       " << trades << " (" << traded << " shares), events " << events << "\n";
+    std::cout << "Misses:       " << misses << " cancels/amends of orders already filled\n";
+    std::cout << "Resting:      " << book.order_count() << " orders\n";
+
+    std::cout << "\nLatency (ns)      count     p50     p90     p99   p99.9       max\n";
+    print_percentiles("add", passive);
+    print_percentiles("add+match", matched);
+    print_percentiles("cancel", cancels);
+    print_percentiles("amend", amends);
+
+    // The incrementally kept top levels must match a walk of the ladder
+    DepthSnapshot top;
+    book.get_top(top);
+    std::vector<PriceLevel> bids, asks;
+    book.get_snapshot(DepthSnapshot::DEPTH + 1, bids, asks);
+    bool same = top.bidcount == std::min(bids.size(), DepthSnapshot::DEPTH)
+        && top.askcount == std::min(asks.size(), DepthSnapshot::DEPTH);
+    for (size_t i = 0; same && i < top.bidcount; i++) {
+        same = top.bids[i].price == bids[i].price && top.bids[i].totalquantity == bids[i].totalquantity;
+    }
+    for (size_t i = 0; same && i < top.askcount; i++) {
+        same = top.asks[i].price == asks[i].price && top.asks[i].totalquantity == asks[i].totalquantity;
+    }
+    if (!same) {
+        std::cerr << "Error: top-of-book depth out of sync with the ladder\n";
+        return 1;
+    }
+
+    PriceLevel bid{}, ask{};
+    if (book.best_bid(bid) && book.best_ask(ask) && book.to_tick(bid.price) >= book.to_tick(ask.price)) {
+        std::cerr << "Error: book left crossed at " << bid.price << " / " << ask.price << "\n";
+        return 1;
+    }
+    return 0;
+}
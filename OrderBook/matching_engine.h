@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "order.h"
+#include "order_book.h"
+
+// Price-time priority matching on top of OrderBook
+//
+// An incoming limit order first walks the opposite side: best price first
+// and, within a price, oldest order first, filling while the resting price
+// is at or better than its limit. Whatever is left rests in the book, so
+// the book never stays crossed. Each match emits a TRADE and one FILL for
+// each side, all at the resting order's price. An order with no quantity,
+// or whose id is already resting, is refused with a single REJECT.
+//
+// Events go into a buffer owned by the engine and cleared per order. Once
+// an order is known to cross, submit() reserves room for three events per
+// opposite-side order it could reach (bounded by its quantity), capped at
+// the constructor's eventcapacity; a sweep past that grows the buffer
+// through push_back. A passive order reserves nothing.
+
+struct MatchEvent {
+    enum Type : uint8_t { TRADE, FILL, REJECT };
+    Type type;
+    bool isbuy;           // TRADE: aggressor side; FILL: side of the filled order
+    uint64_t orderid;     // TRADE: aggressor; FILL: filled order
+    uint64_t contraid;    // TRADE: resting order; FILL: the other side's order
+    double price;
+    uint64_t quantity;
+    uint64_t leaves;      // FILL: quantity still open after this fill
+    uint64_t timestampns;
+};
+
+class MatchingEngine {
+public:
+    explicit MatchingEngine(OrderBook& book, size_t eventcapacity = 4096)
+        : book_(book), eventcapacity_(eventcapacity) {
+        events_.reserve(eventcapacity);
+    }
+
+    // Match order against the book and rest the remainder. Returns the
+    // filled quantity; events() holds what happened.
+    uint64_t submit(const Order& order) {
+        events_.clear();
+        int64_t tick = 0;
+        if (order.quantity == 0 || book_.find(order.orderid, tick) != nullptr) {
+            events_.push_back(MatchEvent{MatchEvent::REJECT, order.isbuy, order.orderid, 0,
+                order.price, order.quantity, 0, order.timestampns});
+            return 0;
+        }
+        uint64_t remaining = order.quantity;
+        int64_t limit = book_.to_tick(order.price);
+        const OrderNode* best = book_.front(!order.isbuy, tick);
+        if (best != nullptr && (order.isbuy ? tick <= limit : tick >= limit)) {
+            uint64_t reachable = std::min<uint64_t>(book_.order_count(!order.isbuy), order.quantity);
+            events_.reserve(std::min<uint64_t>(3 * reachable, eventcapacity_));
+        }
+
+        while (remaining > 0) {
+            const OrderNode* maker = book_.front(!order.isbuy, tick);
+            if (maker == nullptr || (order.isbuy ? tick > limit : tick < limit)) {
+                break;
+            }
+            uint64_t makerid = maker->order.orderid;
+            uint64_t quantity = std::min(remaining, maker->order.quantity);
+            uint64_t makerleaves = maker->order.quantity - quantity;
+            double price = book_.to_price(tick);
+            remaining -= quantity;
+
+            events_.push_back(MatchEvent{MatchEvent::TRADE, order.isbuy, order.orderid, makerid,
+                price, quantity, 0, order.timestampns});
+            events_.push_back(MatchEvent{MatchEvent::FILL, !order.isbuy, makerid, order.orderid,
+                price, quantity, makerleaves, order.timestampns});
+            events_.push_back(MatchEvent{MatchEvent::FILL, order.isbuy, order.orderid, makerid,
+                price, quantity, remaining, order.timestampns});
+            book_.executeorder(makerid, quantity);
+        }
+
+        uint64_t filled = order.quantity - remaining;
+        if (remaining > 0) {
+            Order rest = order;
+            rest.quantity = remaining;
+            book_.addorder(rest);
+        }
+        return filled;
+    }
+
+    bool cancel(uint64_t orderid) {
+        events_.clear();
+        return book_.cancelorder(orderid);
+    }
+
+    // Only a size reduction at the same price keeps the order's place in
+    // the queue. A price change or a size increase re-enters it at the back
+    // (a new price may also cross); amending to zero cancels it.
+    bool amend(uint64_t orderid, double newprice, uint64_t newquantity, uint64_t timestampns) {
+        events_.clear();
+        int64_t tick = 0;
+        const OrderNode* node = book_.find(orderid, tick);
+        if (node == nullptr) return false;
+        if (newquantity == 0) {
+            return book_.cancelorder(orderid);
+        }
+        if (book_.to_tick(newprice) == tick && newquantity <= node->order.quantity) {
+            return book_.amendorder(orderid, newprice, newquantity);
+        }
+        Order order = node->order;
+        order.price = newprice;
+        order.quantity = newquantity;
+        order.timestampns = timestampns;
+        book_.cancelorder(orderid);
+        submit(order);
+        return true;
+    }
+
+    const std::vector<MatchEvent>& events() const { return events_; }
+
+private:
+    OrderBook& book_;
+    size_t eventcapacity_;
+    std::vector<MatchEvent> events_;
+};
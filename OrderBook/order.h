@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+struct Order {
+    uint64_t orderid;
+    bool isbuy;
+    double price;
+    uint64_t quantity;
+    uint64_t timestampns;
+};
+
+struct PriceLevel {
+    double price;
+    uint64_t totalquantity;
+};
+
+// One operation on a book, as replayed by the benchmarks and routed by
+// BookManager
+struct BookOp {
+    enum Type : uint8_t { ADD, CANCEL, AMEND };
+    Type type;
+    Order order;    // ADD: the order; CANCEL: orderid; AMEND: orderid, price, quantity
+};
@@ -0,0 +1,501 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include "order.h"
+#include "order_index.h"
+#include "order_pool.h"
+#include "price_ladder.h"
+
+// Price-ladder order book
+//
+// Prices are converted to integer ticks once, on the way in, so equal
+// prices always land on the same level. Each side keeps its levels in a
+// contiguous array covering a window of ticks around the market, indexed by
+// tick - base_tick_, and an occupancy bitmap marking the non-empty ones.
+// Add and cancel touch one array slot; the best price is cached and, when
+// its level empties, the next one is found through the bitmap. An order
+// outside the window re-centres it on the occupied range (doubling it if
+// the range no longer fits), which is rare once the window covers the
+// day's trading range.
+//
+// The window never grows past maxwindow ticks (MAX_WINDOW_TICKS unless the
+// initial window is larger). Prices too far from the market to fit, such as
+// stub quotes, rest in a per-side overflow map keyed by tick instead; when
+// the market moves, the window is re-centred on the inside prices and the
+// levels it now covers move back into the array.
+//
+// Orders rest in pooled nodes linked into a per-level FIFO (order_pool.h),
+// so cancel unlinks by handle in O(1) and a steady-state add or cancel does
+// not allocate for the order itself. Order IDs map to those handles through
+// a flat open-addressing index (order_index.h) sized for expectedorders;
+// directids > 0 indexes IDs below it directly, for feeds with dense IDs.
+//
+// The best DEPTH levels of each side are also kept, already priced, in a
+// small cache-line-aligned array (DepthSnapshot). A change updates it only
+// when it lands within those levels; anything deeper is rejected with one
+// comparison. Reading the top of the book is then a fixed-size copy.
+
+struct DepthSnapshot {
+    static constexpr size_t DEPTH = 16;     // 4 cache lines per side
+    alignas(64) PriceLevel bids[DEPTH];
+    alignas(64) PriceLevel asks[DEPTH];
+    size_t bidcount = 0;
+    size_t askcount = 0;
+};
+
+class OrderBook {
+public:
+    struct OrderRef {
+        bool isbuy;
+        int64_t tick;
+        OrderNode* node;
+    };
+
+    static constexpr size_t MAX_WINDOW_TICKS = size_t{1} << 16;
+
+    explicit OrderBook(double ticksize = 0.01, size_t windowticks = 4096, size_t expectedorders = 65536,
+                       uint64_t directids = 0)
+        : ticksize_(ticksize), window_(windowticks), max_window_(std::max(windowticks, MAX_WINDOW_TICKS)),
+          pool_(expectedorders), order_lookup_(expectedorders, directids) {
+        bids_.resize(window_);
+        asks_.resize(window_);
+    }
+
+    // Rejects an order whose id is already resting, and the all-ones id,
+    // which the order index reserves
+    bool addorder(const Order& order) { return addorder(order, to_tick(order.price)); }
+
+    // Same, at a price already converted to ticks (order.price is not read)
+    bool addorder(const Order& order, int64_t tick) {
+        if (order.orderid == OrderIndex<OrderRef>::EMPTY || order_lookup_.find(order.orderid) != nullptr) {
+            return false;
+        }
+        Side& side = order.isbuy ? bids_ : asks_;
+        Level& level = level_for_add(side, order.isbuy, tick);
+        OrderNode* node = pool_.acquire(order);
+        level.orders.push_back(node);
+        level.totalquantity += order.quantity;
+        side.orders++;
+        update_top(order.isbuy, tick);
+        order_lookup_.insert_or_assign(order.orderid, OrderRef{order.isbuy, tick, node});
+        return true;
+    }
+
+    bool cancelorder(uint64_t orderid) {
+        const OrderRef* ref = order_lookup_.find(orderid);
+        if (ref == nullptr) return false;
+        remove(orderid, *ref);
+        return true;
+    }
+
+    // Take quantity off a resting order (a fill); removes it when nothing
+    // is left. Keeps its queue position otherwise.
+    bool executeorder(uint64_t orderid, uint64_t quantity) {
+        const OrderRef* ref = order_lookup_.find(orderid);
+        if (ref == nullptr) return false;
+        if (quantity >= ref->node->order.quantity) {
+            remove(orderid, *ref);
+            return true;
+        }
+        Side& side = ref->isbuy ? bids_ : asks_;
+        ref->node->order.quantity -= quantity;
+        find_level(side, ref->tick)->totalquantity -= quantity;
+        update_top(ref->isbuy, ref->tick);
+        return true;
+    }
+
+    // Resting order by id (nullptr if unknown); tick receives its price
+    const OrderNode* find(uint64_t orderid, int64_t& tick) const {
+        const OrderRef* ref = order_lookup_.find(orderid);
+        if (ref == nullptr) return nullptr;
+        tick = ref->tick;
+        return ref->node;
+    }
+
+    // Oldest order at the best price on one side (nullptr if the side is
+    // empty); tick receives that price
+    const OrderNode* front(bool isbuy, int64_t& tick) const {
+        const Side& side = isbuy ? bids_ : asks_;
+        if (!best_tick(side, isbuy, tick)) return nullptr;
+        return find_level(side, tick)->orders.front();
+    }
+
+    int64_t to_tick(double price) const { return std::llround(price / ticksize_); }
+    double to_price(int64_t tick) const { return static_cast<double>(tick) * ticksize_; }
+
+    bool amendorder(uint64_t orderid, double newprice, uint64_t newquantity) {
+        const OrderRef* ref = order_lookup_.find(orderid);
+        if (ref == nullptr) return false;
+        if (to_tick(newprice) != ref->tick) {
+            Order amended = ref->node->order;
+            amended.price = newprice;
+            amended.quantity = newquantity;
+            remove(orderid, *ref);
+            addorder(amended);
+        } else {
+            Side& side = ref->isbuy ? bids_ : asks_;
+            uint64_t oldquantity = ref->node->order.quantity;
+            ref->node->order.quantity = newquantity;
+            find_level(side, ref->tick)->totalquantity += (newquantity - oldquantity);
+            update_top(ref->isbuy, ref->tick);
+        }
+        return true;
+    }
+
+    bool best_bid(PriceLevel& level) const { return best_of(bids_, true, level); }
+    bool best_ask(PriceLevel& level) const { return best_of(asks_, false, level); }
+
+    size_t order_count() const { return order_lookup_.size(); }
+    size_t order_count(bool isbuy) const { return (isbuy ? bids_ : asks_).orders; }
+
+    // Best DepthSnapshot::DEPTH levels per side
+    void get_top(DepthSnapshot& out) const { out = top_; }
+
+    void get_snapshot(size_t depth, std::vector<PriceLevel>& bids, std::vector<PriceLevel>& asks) const {
+        if (depth <= DepthSnapshot::DEPTH) {
+            bids.assign(top_.bids, top_.bids + std::min(depth, top_.bidcount));
+            asks.assign(top_.asks, top_.asks + std::min(depth, top_.askcount));
+            return;
+        }
+        auto walk = [&](const Side& side, bool isbuy, std::vector<PriceLevel>& out) {
+            out.clear();
+            int64_t tick = 0;
+            for (bool more = best_tick(side, isbuy, tick); more && out.size() < depth;
+                 more = next_worse(side, isbuy, tick, tick)) {
+                out.push_back(PriceLevel{to_price(tick), find_level(side, tick)->totalquantity});
+            }
+        };
+        walk(bids_, true, bids);
+        walk(asks_, false, asks);
+    }
+
+    void print_book(size_t depth = 10) const {
+        std::vector<PriceLevel> bids, asks;
+        get_snapshot(depth, bids, asks);
+
+        std::cout << "Order Book Snapshot (Top " << depth << " levels)\n";
+        std::cout << "-------------------------------\n";
+        std::cout << "   Bids       |      Asks      \n";
+        std::cout << "Price  Qty    |  Price   Qty   \n";
+        std::cout << "-------------------------------\n";
+
+        for (size_t i = 0; i < depth; ++i) {
+            // Print bid
+            if (i < bids.size()) {
+                std::cout << std::setw(6) << bids[i].price << " ";
+                std::cout << std::setw(6) << bids[i].totalquantity << " | ";
+            } else {
+                std::cout << "              | ";
+            }
+
+            // Print ask
+            if (i < asks.size()) {
+                std::cout << std::setw(6) << asks[i].price << " ";
+                std::cout << std::setw(6) << asks[i].totalquantity;
+            }
+            std::cout << "\n";
+        }
+        std::cout << "-------------------------------\n";
+    }
+
+private:
+    struct Level {
+        uint64_t totalquantity = 0;
+        OrderQueue orders;
+    };
+
+    struct Side {
+        std::vector<Level> levels;     // Indexed by tick - base_tick_
+        OccupancyBitmap occupied;
+        int64_t best = OccupancyBitmap::NONE;
+        std::array<int64_t, DepthSnapshot::DEPTH> topticks{};   // Ticks of the levels in top_, best first
+        std::map<int64_t, Level> overflow;                      // Levels outside the window, by tick
+        size_t orders = 0;                                      // Resting on this side
+
+        void resize(size_t size) {
+            levels.assign(size, Level{});
+            occupied.resize(size);
+            best = OccupancyBitmap::NONE;
+        }
+    };
+
+    // ref is taken by value: erasing from the index may move its slot
+    void remove(uint64_t orderid, OrderRef ref) {
+        Side& side = ref.isbuy ? bids_ : asks_;
+        Level& level = *find_level(side, ref.tick);
+        level.totalquantity -= ref.node->order.quantity;
+        level.orders.erase(ref.node);
+        side.orders--;
+        pool_.release(ref.node);
+        bool emptied = level.orders.empty();
+        if (emptied && in_window(ref.tick)) {
+            size_t i = static_cast<size_t>(ref.tick - base_tick_);
+            side.occupied.clear(i);
+            if (static_cast<int64_t>(i) == side.best) {
+                side.best = ref.isbuy ? side.occupied.find_prev(side.best) : side.occupied.find_next(side.best);
+            }
+        } else if (emptied) {
+            side.overflow.erase(ref.tick);
+        }
+        update_top(ref.isbuy, ref.tick);
+        order_lookup_.erase(orderid);
+        if (emptied) {
+            follow_market(ref.isbuy);
+        }
+    }
+
+    // Bring top_ in line with the level at tick after it changed: new
+    // quantity, newly occupied (insert, pushing the last one out) or
+    // emptied (erase, pulling the next level in from the bitmap)
+    void update_top(bool isbuy, int64_t tick) {
+        Side& side = isbuy ? bids_ : asks_;
+        PriceLevel* top = isbuy ? top_.bids : top_.asks;
+        size_t& count = isbuy ? top_.bidcount : top_.askcount;
+        auto better = [isbuy](int64_t a, int64_t b) { return isbuy ? a > b : a < b; };
+
+        constexpr size_t DEPTH = DepthSnapshot::DEPTH;
+        if (count == DEPTH && better(side.topticks[DEPTH - 1], tick)) {
+            return;     // Below the top levels
+        }
+        size_t pos = 0;
+        while (pos < count && better(side.topticks[pos], tick)) {
+            pos++;
+        }
+        bool present = pos < count && side.topticks[pos] == tick;
+        const Level* level = find_level(side, tick);
+
+        if (level != nullptr && !level->orders.empty()) {
+            if (!present) {
+                size_t last = std::min(count, DEPTH - 1);
+                std::copy_backward(top + pos, top + last, top + last + 1);
+                std::copy_backward(side.topticks.begin() + pos, side.topticks.begin() + last,
+                                   side.topticks.begin() + last + 1);
+                side.topticks[pos] = tick;
+                top[pos].price = to_price(tick);
+                count = last + 1;
+            }
+            top[pos].totalquantity = level->totalquantity;
+            return;
+        }
+        if (!present) return;
+
+        int64_t edge = side.topticks[count - 1];
+        std::copy(top + pos + 1, top + count, top + pos);
+        std::copy(side.topticks.begin() + pos + 1, side.topticks.begin() + count, side.topticks.begin() + pos);
+        count--;
+        if (count == DEPTH - 1) {
+            int64_t next = 0;
+            if (next_worse(side, isbuy, edge, next)) {
+                side.topticks[count] = next;
+                top[count] = PriceLevel{to_price(next), find_level(side, next)->totalquantity};
+                count++;
+            }
+        }
+    }
+
+    bool in_window(int64_t tick) const {
+        return anchored_ && tick >= base_tick_ && tick < base_tick_ + static_cast<int64_t>(window_);
+    }
+
+    // Level at tick, in the window or the overflow map; nullptr if an
+    // overflow level does not exist
+    Level* find_level(Side& side, int64_t tick) {
+        if (in_window(tick)) {
+            return &side.levels[static_cast<size_t>(tick - base_tick_)];
+        }
+        auto it = side.overflow.find(tick);
+        return it == side.overflow.end() ? nullptr : &it->second;
+    }
+
+    const Level* find_level(const Side& side, int64_t tick) const {
+        return const_cast<OrderBook*>(this)->find_level(const_cast<Side&>(side), tick);
+    }
+
+    // Level an order at tick joins, moving the window to cover tick if it
+    // reasonably can and falling back to the overflow map otherwise
+    Level& level_for_add(Side& side, bool isbuy, int64_t tick) {
+        if (!in_window(tick)) {
+            place_window(isbuy, tick);
+        }
+        if (!in_window(tick)) {
+            return side.overflow[tick];
+        }
+        size_t i = static_cast<size_t>(tick - base_tick_);
+        side.occupied.set(i);
+        if (side.best == OccupancyBitmap::NONE
+            || (isbuy ? static_cast<int64_t>(i) > side.best : static_cast<int64_t>(i) < side.best)) {
+            side.best = static_cast<int64_t>(i);
+        }
+        return side.levels[i];
+    }
+
+    // Best occupied tick on a side, across the window and the overflow map
+    bool best_tick(const Side& side, bool isbuy, int64_t& tick) const {
+        bool found = false;
+        if (side.best != OccupancyBitmap::NONE) {
+            tick = base_tick_ + side.best;
+            found = true;
+        }
+        if (!side.overflow.empty()) {
+            int64_t far = isbuy ? side.overflow.rbegin()->first : side.overflow.begin()->first;
+            if (!found || (isbuy ? far > tick : far < tick)) {
+                tick = far;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // Next occupied tick strictly worse than from on a side
+    bool next_worse(const Side& side, bool isbuy, int64_t from, int64_t& tick) const {
+        bool found = false;
+        int64_t window = static_cast<int64_t>(window_);
+        if (isbuy) {
+            int64_t i = side.occupied.find_prev(std::min(from - 1 - base_tick_, window - 1));
+            if (i != OccupancyBitmap::NONE) {
+                tick = base_tick_ + i;
+                found = true;
+            }
+            auto it = side.overflow.lower_bound(from);
+            if (it != side.overflow.begin() && (!found || std::prev(it)->first > tick)) {
+                tick = std::prev(it)->first;
+                found = true;
+            }
+        } else {
+            int64_t i = side.occupied.find_next(std::max<int64_t>(from + 1 - base_tick_, 0));
+            if (i != OccupancyBitmap::NONE) {
+                tick = base_tick_ + i;
+                found = true;
+            }
+            auto it = side.overflow.upper_bound(from);
+            if (it != side.overflow.end() && (!found || it->first < tick)) {
+                tick = it->first;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    bool best_of(const Side& side, bool isbuy, PriceLevel& level) const {
+        int64_t tick = 0;
+        if (!best_tick(side, isbuy, tick)) return false;
+        level = PriceLevel{to_price(tick), find_level(side, tick)->totalquantity};
+        return true;
+    }
+
+    // Middle of the inside market, counting a new order at tick on one side
+    int64_t touch_center(bool isbuy, int64_t tick) const {
+        int64_t bid = 0, ask = 0;
+        bool hasbid = best_tick(bids_, true, bid);
+        bool hasask = best_tick(asks_, false, ask);
+        if (isbuy && (!hasbid || tick > bid)) {
+            bid = tick;
+            hasbid = true;
+        } else if (!isbuy && (!hasask || tick < ask)) {
+            ask = tick;
+            hasask = true;
+        }
+        if (hasbid && hasask) return bid + (ask - bid) / 2;
+        return hasbid ? bid : ask;
+    }
+
+    // Move the window so it covers tick, if that keeps it within max_window_
+    void place_window(bool isbuy, int64_t tick) {
+        if (!anchored_) {
+            base_tick_ = tick - static_cast<int64_t>(window_ / 2);
+            anchored_ = true;
+            return;
+        }
+        // Grow over the occupied part of the window plus tick while it fits
+        int64_t lo = tick, hi = tick;
+        for (const Side* side : {&bids_, &asks_}) {
+            int64_t first = side->occupied.find_next(0);
+            if (first != OccupancyBitmap::NONE) {
+                lo = std::min(lo, base_tick_ + first);
+                hi = std::max(hi, base_tick_ + side->occupied.find_prev(static_cast<int64_t>(window_) - 1));
+            }
+        }
+        size_t size = window_;
+        while (static_cast<size_t>(hi - lo + 1) > size / 2 && size < max_window_) {
+            size *= 2;  // Keep headroom on both sides of the occupied range
+        }
+        if (static_cast<size_t>(hi - lo + 1) <= size / 2) {
+            rebuild((lo + hi) / 2 - static_cast<int64_t>(size / 2), size);
+            return;
+        }
+        // Too wide for any window: centre the largest one on the inside
+        // market, and only if that brings tick in; far prices stay in overflow
+        int64_t base = touch_center(isbuy, tick) - static_cast<int64_t>(max_window_ / 2);
+        if (tick >= base && tick < base + static_cast<int64_t>(max_window_)) {
+            rebuild(base, max_window_);
+        }
+    }
+
+    // After a level empties: if a side's best is now outside the window
+    // (the market moved into the overflow map), re-centre on the touch
+    void follow_market(bool isbuy) {
+        const Side& side = isbuy ? bids_ : asks_;
+        int64_t best = 0;
+        if (!best_tick(side, isbuy, best) || in_window(best)) return;
+        int64_t center = touch_center(isbuy, best);
+        for (size_t size = window_; size <= max_window_; size *= 2) {
+            int64_t base = center - static_cast<int64_t>(size / 2);
+            if (best >= base && best < base + static_cast<int64_t>(size)) {
+                rebuild(base, size);
+                return;
+            }
+        }
+    }
+
+    // Move every level into a window of size ticks starting at base, and
+    // into or out of the overflow map as the new window covers it. Levels
+    // only hold node pointers, so the handles in order_lookup_ stay valid.
+    void rebuild(int64_t base, size_t size) {
+        for (bool isbuy : {true, false}) {
+            Side& side = isbuy ? bids_ : asks_;
+            Side moved;
+            moved.resize(size);
+            moved.topticks = side.topticks;
+            moved.orders = side.orders;
+            auto place = [&](int64_t tick, const Level& level) {
+                if (tick >= base && tick < base + static_cast<int64_t>(size)) {
+                    size_t j = static_cast<size_t>(tick - base);
+                    moved.levels[j] = level;
+                    moved.occupied.set(j);
+                } else {
+                    moved.overflow.emplace(tick, level);
+                }
+            };
+            for (int64_t i = side.occupied.find_next(0); i != OccupancyBitmap::NONE;
+                 i = side.occupied.find_next(i + 1)) {
+                place(base_tick_ + i, side.levels[i]);
+            }
+            for (const auto& [tick, level] : side.overflow) {
+                place(tick, level);
+            }
+            moved.best = isbuy ? moved.occupied.find_prev(static_cast<int64_t>(size) - 1)
+                               : moved.occupied.find_next(0);
+            side = std::move(moved);
+        }
+        base_tick_ = base;
+        window_ = size;
+    }
+
+    double ticksize_;
+    size_t window_;
+    size_t max_window_;
+    int64_t base_tick_ = 0;
+    bool anchored_ = false;
+    Side bids_;
+    Side asks_;
+    OrderPool pool_;
+    OrderIndex<OrderRef> order_lookup_;
+    DepthSnapshot top_;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "order.h"
+
+// Synthetic order flow for the book benchmarks
+//
+// A mid price random-walks one tick at a time. New orders rest a few ticks
+// from it, exponentially fewer the further out (most activity is near the
+// touch), and never cross it. Adds and cancels are balanced to hold the
+// book near a target number of live orders; one operation in ten is an
+// amend, most of them quantity-only. Cancels and amends pick a live order
+// uniformly at random.
+//
+// With aggressive_share > 0 that fraction of adds is priced through the mid
+// instead, up to a few ticks into the opposite side, so a matching engine
+// sees marketable orders. The generator does not model the fills: an
+// aggressive order is not counted as live, and a resting order it consumed
+// may still be picked for a later cancel or amend, which then misses.
+
+inline std::vector<BookOp> make_order_flow(size_t count, size_t live_target, uint32_t seed = 42,
+                                           double ticksize = 0.01, int64_t start_tick = 10'000,
+                                           double aggressive_share = 0.0) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::exponential_distribution<double> distance(1.0 / 6.0);   // Mean 6 ticks from mid
+    std::uniform_int_distribution<uint64_t> lots(1, 10);
+    std::uniform_int_distribution<int64_t> through(0, 3);
+
+    struct Live {
+        uint64_t orderid;
+        bool isbuy;
+        int64_t tick;
+    };
+    std::vector<Live> live;
+    live.reserve(live_target * 2);
+    std::vector<BookOp> ops;
+    ops.reserve(count);
+
+    int64_t mid = start_tick;
+    uint64_t nextid = 1;
+    uint64_t timestamp = 0;
+    auto price_of = [&](int64_t tick) { return static_cast<double>(tick) * ticksize; };
+    auto away = [&](bool isbuy) {
+        int64_t d = 1 + static_cast<int64_t>(distance(rng));
+        return isbuy ? mid - d : mid + d;
+    };
+
+    for (size_t n = 0; n < count; n++) {
+        timestamp += 1'000;
+        if (n % 50 == 0) {
+            mid += unit(rng) < 0.5 ? -1 : 1;
+        }
+
+        double add_share = live.size() < live_target ? 0.6 : 0.4;
+        double r = unit(rng);
+        if (live.empty() || r < add_share) {
+            bool isbuy = unit(rng) < 0.5;
+            if (aggressive_share > 0.0 && unit(rng) < aggressive_share) {
+                int64_t tick = isbuy ? mid + through(rng) : mid - through(rng);
+                ops.push_back(BookOp{BookOp::ADD, Order{nextid++, isbuy, price_of(tick), lots(rng) * 100, timestamp}});
+                continue;
+            }
+            int64_t tick = away(isbuy);
+            Order order{nextid++, isbuy, price_of(tick), lots(rng) * 100, timestamp};
+            live.push_back(Live{order.orderid, isbuy, tick});
+            ops.push_back(BookOp{BookOp::ADD, order});
+            continue;
+        }
+
+        size_t pick = static_cast<size_t>(unit(rng) * static_cast<double>(live.size()));
+        pick = std::min(pick, live.size() - 1);
+        Live& target = live[pick];
+        if (r < 0.9) {
+            ops.push_back(BookOp{BookOp::CANCEL, Order{target.orderid, target.isbuy, 0.0, 0, timestamp}});
+            target = live.back();
+            live.pop_back();
+        } else {
+            // Amend: 70% quantity only, otherwise a new price (loses priority)
+            if (unit(rng) >= 0.7) {
+                target.tick = away(target.isbuy);
+            }
+            ops.push_back(BookOp{BookOp::AMEND,
+                Order{target.orderid, target.isbuy, price_of(target.tick), lots(rng) * 100, timestamp}});
+        }
+    }
+    return ops;
+}
+
+template<typename Book>
+inline void apply(Book& book, const BookOp& op) {
+    switch (op.type) {
+    case BookOp::ADD:
+        book.addorder(op.order);
+        break;
+    case BookOp::CANCEL:
+        book.cancelorder(op.order.orderid);
+        break;
+    case BookOp::AMEND:
+        book.amendorder(op.order.orderid, op.order.price, op.order.quantity);
+        break;
+    }
+}
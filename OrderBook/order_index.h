@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Order ID -> value index for the book
+//
+// A flat open-addressing table: slots hold the key and value inline, probing
+// is linear from a multiplicative hash, and erase shifts the following run
+// back into the hole instead of leaving a tombstone, so lookups never scan
+// past deleted entries and the table does not degrade under churn. It is
+// sized up front for the expected number of live orders at a load factor of
+// at most 1/2 and only rehashes (doubling) past 3/4.
+//
+// When exchange order IDs are dense, directlimit > 0 adds a direct-indexed
+// array for IDs below it: one slot per ID, no hashing or probing. IDs at or
+// above the limit still go to the hash table.
+//
+// The all-ones ID marks an empty slot and cannot be stored: insert_or_assign
+// refuses it, and find and erase report it as absent.
+template<typename V>
+class OrderIndex {
+public:
+    static constexpr uint64_t EMPTY = ~uint64_t{0};
+
+    explicit OrderIndex(size_t expected = 65536, uint64_t directlimit = 0) {
+        size_t capacity = 16;
+        while (capacity < expected * 2) {
+            capacity *= 2;
+        }
+        resize(capacity);
+        direct_.assign(static_cast<size_t>(directlimit), Slot{});
+    }
+
+    size_t size() const { return size_; }
+
+    V* find(uint64_t key) {
+        if (key == EMPTY) return nullptr;
+        if (key < direct_.size()) {
+            Slot& slot = direct_[key];
+            return slot.key == EMPTY ? nullptr : &slot.value;
+        }
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            Slot& slot = slots_[i];
+            if (slot.key == key) return &slot.value;
+            if (slot.key == EMPTY) return nullptr;
+        }
+    }
+
+    const V* find(uint64_t key) const { return const_cast<OrderIndex*>(this)->find(key); }
+
+    // False (and nothing stored) only for the reserved EMPTY key
+    bool insert_or_assign(uint64_t key, const V& value) {
+        if (key == EMPTY) return false;
+        if (key < direct_.size()) {
+            Slot& slot = direct_[key];
+            size_ += slot.key == EMPTY ? 1 : 0;
+            slot = Slot{key, value};
+            return true;
+        }
+        if ((hashed_ + 1) * 4 > slots_.size() * 3) {
+            rehash(slots_.size() * 2);
+        }
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            Slot& slot = slots_[i];
+            if (slot.key == key) {
+                slot.value = value;
+                return true;
+            }
+            if (slot.key == EMPTY) {
+                slot = Slot{key, value};
+                hashed_++;
+                size_++;
+                return true;
+            }
+        }
+    }
+
+    bool erase(uint64_t key) {
+        if (key == EMPTY) return false;
+        if (key < direct_.size()) {
+            Slot& slot = direct_[key];
+            if (slot.key == EMPTY) return false;
+            slot.key = EMPTY;
+            size_--;
+            return true;
+        }
+        size_t hole = home(key);
+        for (;; hole = (hole + 1) & mask_) {
+            if (slots_[hole].key == key) break;
+            if (slots_[hole].key == EMPTY) return false;
+        }
+        // Pull back every later entry in the run that may sit in the hole,
+        // i.e. whose home is not between the hole and its current slot
+        for (size_t i = (hole + 1) & mask_; slots_[i].key != EMPTY; i = (i + 1) & mask_) {
+            size_t distance = (i - home(slots_[i].key)) & mask_;
+            if (distance >= ((i - hole) & mask_)) {
+                slots_[hole] = slots_[i];
+                hole = i;
+            }
+        }
+        slots_[hole].key = EMPTY;
+        hashed_--;
+        size_--;
+        return true;
+    }
+
+private:
+    struct Slot {
+        uint64_t key = EMPTY;
+        V value{};
+    };
+
+    size_t home(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    void resize(size_t capacity) {
+        slots_.assign(capacity, Slot{});
+        mask_ = capacity - 1;
+        shift_ = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) {
+            shift_--;
+        }
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        resize(capacity);
+        for (const Slot& slot : old) {
+            if (slot.key == EMPTY) continue;
+            size_t i = home(slot.key);
+            while (slots_[i].key != EMPTY) {
+                i = (i + 1) & mask_;
+            }
+            slots_[i] = slot;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<Slot> direct_;
+    size_t mask_ = 0;
+    unsigned shift_ = 64;
+    size_t hashed_ = 0;     // Entries in slots_
+    size_t size_ = 0;       // Entries overall
+};
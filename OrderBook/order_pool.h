@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "order.h"
+
+// Order storage for the price levels
+//
+// Every resting order lives in an OrderNode drawn from OrderPool. Nodes
+// carry their own prev/next links, so a level's FIFO (OrderQueue) is an
+// intrusive doubly-linked list: appending and unlinking by node pointer are
+// O(1), and a node's address never changes while the order rests, so the
+// pointer is a stable handle for cancels and amends. The pool hands out
+// nodes from preallocated chunks and takes them back on a free list; it
+// only allocates when more orders rest at once than ever before.
+
+struct OrderNode {
+    Order order;
+    OrderNode* prev;
+    OrderNode* next;
+};
+
+class OrderPool {
+public:
+    explicit OrderPool(size_t capacity = 65536) { grow(capacity > 0 ? capacity : 1); }
+
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+
+    OrderNode* acquire(const Order& order) {
+        if (free_ == nullptr) {
+            grow(capacity_);  // Double
+        }
+        OrderNode* node = free_;
+        free_ = node->next;
+        node->order = order;
+        node->prev = nullptr;
+        node->next = nullptr;
+        return node;
+    }
+
+    void release(OrderNode* node) {
+        node->next = free_;
+        free_ = node;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    void grow(size_t count) {
+        chunks_.push_back(std::make_unique<OrderNode[]>(count));
+        OrderNode* chunk = chunks_.back().get();
+        for (size_t i = 0; i < count; i++) {
+            chunk[i].next = i + 1 < count ? &chunk[i + 1] : free_;
+        }
+        free_ = chunk;
+        capacity_ += count;
+    }
+
+    std::vector<std::unique_ptr<OrderNode[]>> chunks_;
+    OrderNode* free_ = nullptr;
+    size_t capacity_ = 0;
+};
+
+// FIFO of the orders resting at one price, oldest first
+class OrderQueue {
+public:
+    bool empty() const { return head_ == nullptr; }
+    OrderNode* front() const { return head_; }
+
+    void push_back(OrderNode* node) {
+        node->prev = tail_;
+        node->next = nullptr;
+        if (tail_ != nullptr) {
+            tail_->next = node;
+        } else {
+            head_ = node;
+        }
+        tail_ = node;
+    }
+
+    void erase(OrderNode* node) {
+        if (node->prev != nullptr) {
+            node->prev->next = node->next;
+        } else {
+            head_ = node->next;
+        }
+        if (node->next != nullptr) {
+            node->next->prev = node->prev;
+        } else {
+            tail_ = node->prev;
+        }
+    }
+
+private:
+    OrderNode* head_ = nullptr;
+    OrderNode* tail_ = nullptr;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One bit per tick of the ladder window, with a summary word per 64 words
+// so the next occupied tick in either direction is found by scanning at
+// most one word, a few summary words and one more word, instead of walking
+// empty levels.
+class OccupancyBitmap {
+public:
+    static constexpr int64_t NONE = -1;
+
+    explicit OccupancyBitmap(size_t bits = 0) { resize(bits); }
+
+    void resize(size_t bits) {
+        words_.assign((bits + 63) / 64, 0);
+        summary_.assign((words_.size() + 63) / 64, 0);
+    }
+
+    void set(size_t i) {
+        words_[i / 64] |= uint64_t{1} << (i % 64);
+        summary_[i / 4096] |= uint64_t{1} << ((i / 64) % 64);
+    }
+
+    void clear(size_t i) {
+        uint64_t& word = words_[i / 64];
+        word &= ~(uint64_t{1} << (i % 64));
+        if (word == 0) {
+            summary_[i / 4096] &= ~(uint64_t{1} << ((i / 64) % 64));
+        }
+    }
+
+    bool test(size_t i) const {
+        return (words_[i / 64] >> (i % 64)) & 1;
+    }
+
+    // Lowest set bit at or above i, or NONE
+    int64_t find_next(int64_t i) const {
+        if (i < 0) {
+            i = 0;
+        }
+        size_t w = static_cast<size_t>(i) / 64;
+        if (w >= words_.size()) {
+            return NONE;
+        }
+        uint64_t word = words_[w] & (~uint64_t{0} << (i % 64));
+        if (word != 0) {
+            return static_cast<int64_t>(w * 64 + __builtin_ctzll(word));
+        }
+        // Next non-empty word after w
+        size_t s = (w + 1) / 64;
+        if (s >= summary_.size()) {
+            return NONE;
+        }
+        uint64_t summary = (w + 1) % 64 == 0 ? summary_[s] : summary_[s] & (~uint64_t{0} << ((w + 1) % 64));
+        while (summary == 0) {
+            if (++s >= summary_.size()) {
+                return NONE;
+            }
+            summary = summary_[s];
+        }
+        w = s * 64 + __builtin_ctzll(summary);
+        return static_cast<int64_t>(w * 64 + __builtin_ctzll(words_[w]));
+    }
+
+    // Highest set bit at or below i, or NONE
+    int64_t find_prev(int64_t i) const {
+        if (i < 0 || words_.empty()) {
+            return NONE;
+        }
+        if (static_cast<size_t>(i) >= words_.size() * 64) {
+            i = static_cast<int64_t>(words_.size() * 64 - 1);
+        }
+        size_t w = static_cast<size_t>(i) / 64;
+        uint64_t word = words_[w] & (~uint64_t{0} >> (63 - i % 64));
+        if (word != 0) {
+            return static_cast<int64_t>(w * 64 + 63 - __builtin_clzll(word));
+        }
+        // Previous non-empty word before w
+        if (w == 0) {
+            return NONE;
+        }
+        size_t prev = w - 1;
+        size_t s = prev / 64;
+        uint64_t summary = summary_[s] & (~uint64_t{0} >> (63 - prev % 64));
+        while (summary == 0) {
+            if (s == 0) {
+                return NONE;
+            }
+            summary = summary_[--s];
+        }
+        w = s * 64 + 63 - __builtin_clzll(summary);
+        return static_cast<int64_t>(w * 64 + 63 - __builtin_clzll(words_[w]));
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> summary_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer/single-consumer queue between book threads
+//
+// Fifo3 from SPSC_QUEUES (monotonically increasing cursors on separate
+// cache lines) with each side also keeping a cached copy of the other's
+// cursor, so it only reads the shared line when the cached view says full
+// (producer) or empty (consumer). Capacity is rounded up to a power of two.
+template<typename T>
+class alignas(64) SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        ring_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side; false if full
+    bool try_push(const T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == ring_.size()) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == ring_.size()) {
+                return false;
+            }
+        }
+        ring_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false if empty
+    bool try_pop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        value = ring_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> ring_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};   // Written by the producer
+    size_t head_cache_ = 0;                     // Producer's view of head_
+    alignas(64) std::atomic<size_t> head_{0};   // Written by the consumer
+    size_t tail_cache_ = 0;                     // Consumer's view of tail_
+};
@@ -0,0 +1,244 @@
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <benchmark/benchmark.h>
+
+#include "spsc_q3.cpp"
+#include "../SHM_MMAP/SHM.h"
+#include "../MarketDataSystem/include/ring_buffer.h"
+
+// SPSC queue comparison: RingBuffer (SpscRing), Fifo3 and SHM
+//
+// Throughput: the benchmark thread pushes one element per iteration while a
+// second thread pops them all. Ping-pong: the benchmark thread pushes into
+// one queue and waits for the echo thread to send the element back through
+// a second queue, so time per iteration is a round trip.
+//
+// The first argument selects where the two threads run:
+//   0 same core, 1 sibling hyperthread, 2 another physical core.
+// Placements the machine cannot provide are skipped. On the same core a
+// failed push/pop yields, otherwise the threads spin.
+//
+// SHM stores ints in a fixed 4M-slot array, so it only runs with the 4-byte
+// payload at that capacity.
+
+namespace {
+
+template<size_t N>
+struct Payload {
+    char bytes[N];
+};
+
+enum Placement { SAME_CORE = 0, SIBLING = 1, CROSS_CORE = 2 };
+
+std::set<int> read_cpu_list(const std::string& path) {
+    std::set<int> cpus;
+    std::ifstream file(path);
+    std::string range;
+    while (std::getline(file, range, ',')) {
+        size_t dash = range.find('-');
+        int first = std::stoi(range);
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.insert(cpu);
+        }
+    }
+    return cpus;
+}
+
+// CPUs for the benchmark thread and its partner, or false if unavailable
+bool pick_cpus(Placement placement, int& first, int& second) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return false;
+    }
+    first = -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE && first == -1; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            first = cpu;
+        }
+    }
+    if (first == -1) {
+        return false;
+    }
+    if (placement == SAME_CORE) {
+        second = first;
+        return true;
+    }
+
+    std::set<int> siblings = read_cpu_list(
+        "/sys/devices/system/cpu/cpu" + std::to_string(first) + "/topology/thread_siblings_list");
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (cpu == first || !CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        bool sibling = siblings.count(cpu) != 0;
+        if (sibling == (placement == SIBLING)) {
+            second = cpu;
+            return true;
+        }
+    }
+    return false;
+}
+
+void pin(int cpu) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+}
+
+// Restores the benchmark thread's affinity when a run ends
+class ScopedPin {
+public:
+    explicit ScopedPin(int cpu) {
+        sched_getaffinity(0, sizeof(saved_), &saved_);
+        pin(cpu);
+    }
+    ~ScopedPin() { pthread_setaffinity_np(pthread_self(), sizeof(saved_), &saved_); }
+
+private:
+    cpu_set_t saved_;
+};
+
+inline void backoff(bool yield) {
+    if (yield) {
+        std::this_thread::yield();
+    }
+}
+
+// Uniform construction for the three queues
+template<typename T, uint32_t Capacity>
+struct RingBufferQueue {
+    using Queue = SpscRing<T, Capacity>;
+    using value_type = T;
+    static std::unique_ptr<Queue> make() { return std::make_unique<Queue>(); }
+};
+
+template<typename T, size_t Capacity>
+struct Fifo3Queue {
+    using Queue = Fifo3<T>;
+    using value_type = T;
+    static std::unique_ptr<Queue> make() { return std::make_unique<Queue>(Capacity); }
+};
+
+struct ShmQueue {
+    using Queue = SHM;
+    using value_type = int;
+    static std::unique_ptr<Queue> make() { return std::make_unique<Queue>(); }
+};
+
+template<typename Q>
+void BM_Throughput(benchmark::State& state) {
+    using T = typename Q::value_type;
+    int first, second;
+    Placement placement = static_cast<Placement>(state.range(0));
+    if (!pick_cpus(placement, first, second)) {
+        state.SkipWithError("placement not available on this machine");
+        return;
+    }
+    bool yield = placement == SAME_CORE;
+    auto queue = Q::make();
+    const uint64_t total = state.max_iterations;
+
+    std::thread consumer([&] {
+        pin(second);
+        T value;
+        for (uint64_t received = 0; received < total;) {
+            if (queue->pop(value)) {
+                benchmark::DoNotOptimize(value);
+                received++;
+            } else {
+                backoff(yield);
+            }
+        }
+    });
+
+    ScopedPin scoped(first);
+    T value{};
+    for (auto _ : state) {
+        reinterpret_cast<char*>(&value)[0]++;
+        while (!queue->push(value)) {
+            backoff(yield);
+        }
+    }
+    consumer.join();
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sizeof(T));
+}
+
+template<typename Q>
+void BM_PingPong(benchmark::State& state) {
+    using T = typename Q::value_type;
+    int first, second;
+    Placement placement = static_cast<Placement>(state.range(0));
+    if (!pick_cpus(placement, first, second)) {
+        state.SkipWithError("placement not available on this machine");
+        return;
+    }
+    bool yield = placement == SAME_CORE;
+    auto ping = Q::make();
+    auto pong = Q::make();
+    const uint64_t total = state.max_iterations;
+
+    std::thread echo([&] {
+        pin(second);
+        T value;
+        for (uint64_t echoed = 0; echoed < total; echoed++) {
+            while (!ping->pop(value)) {
+                backoff(yield);
+            }
+            while (!pong->push(value)) {
+                backoff(yield);
+            }
+        }
+    });
+
+    ScopedPin scoped(first);
+    T value{};
+    for (auto _ : state) {
+        while (!ping->push(value)) {
+            backoff(yield);
+        }
+        while (!pong->pop(value)) {
+            backoff(yield);
+        }
+    }
+    echo.join();
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void placements(benchmark::internal::Benchmark* b) {
+    b->ArgName("placement")->Arg(SAME_CORE)->Arg(SIBLING)->Arg(CROSS_CORE)->UseRealTime();
+}
+
+#define SPSC_BENCH(...) \
+    BENCHMARK_TEMPLATE(BM_Throughput, __VA_ARGS__)->Apply(placements); \
+    BENCHMARK_TEMPLATE(BM_PingPong, __VA_ARGS__)->Apply(placements)
+
+#define SPSC_BENCH_PAYLOAD(N, CAPACITY) \
+    SPSC_BENCH(RingBufferQueue<Payload<N>, CAPACITY>); \
+    SPSC_BENCH(Fifo3Queue<Payload<N>, CAPACITY>)
+
+#define SPSC_BENCH_CAPACITY(CAPACITY) \
+    SPSC_BENCH_PAYLOAD(4, CAPACITY); \
+    SPSC_BENCH_PAYLOAD(16, CAPACITY); \
+    SPSC_BENCH_PAYLOAD(64, CAPACITY); \
+    SPSC_BENCH_PAYLOAD(256, CAPACITY)
+
+SPSC_BENCH_CAPACITY(256);
+SPSC_BENCH_CAPACITY(4096);
+SPSC_BENCH_CAPACITY(65536);
+SPSC_BENCH(ShmQueue);
+
+} // namespace
+
+BENCHMARK_MAIN();